@@ -0,0 +1,423 @@
+#include <benchmark/benchmark.h>
+#include "../src/bencode.h"
+#include "../src/bencode_index.h"
+#include "../src/bencode_lazy_view.h"
+#include "../src/bencode_literal.h"
+#include "../src/bencode_schema.h"
+#include "../src/bencode_writer.h"
+#include "bench_support.h"
+
+#include <exception>
+#include <format>
+#include <memory_resource>
+#include <vector>
+
+static void BM_ParseDefaultResource(benchmark::State& state) {
+    std::string input = file_list_input(state.range(0));
+    AllocationCounter allocations(state);
+    for (auto _ : state) {
+        Bencode output = Bencode::Parse(std::string_view(input));
+        benchmark::DoNotOptimize(output);
+    }
+    state.SetBytesProcessed(state.iterations() * input.size());
+}
+BENCHMARK(BM_ParseDefaultResource)->Arg(1'000)->Arg(200'000);
+
+static void BM_ParseMonotonicArena(benchmark::State& state) {
+    std::string input = file_list_input(state.range(0));
+    AllocationCounter allocations(state);
+    for (auto _ : state) {
+        std::pmr::monotonic_buffer_resource arena(input.size());
+        Bencode output = Bencode::Parse(input, arena);
+        benchmark::DoNotOptimize(output);
+    }
+    state.SetBytesProcessed(state.iterations() * input.size());
+}
+BENCHMARK(BM_ParseMonotonicArena)->Arg(1'000)->Arg(200'000);
+
+static void BM_ParsePooledArena(benchmark::State& state) {
+    std::string input = file_list_input(state.range(0));
+    std::pmr::unsynchronized_pool_resource pool;
+    AllocationCounter allocations(state);
+    for (auto _ : state) {
+        Bencode output = Bencode::Parse(input, pool);
+        benchmark::DoNotOptimize(output);
+    }
+    state.SetBytesProcessed(state.iterations() * input.size());
+}
+BENCHMARK(BM_ParsePooledArena)->Arg(1'000)->Arg(200'000);
+
+static void BM_ParseParallel(benchmark::State& state) {
+    std::string input = file_list_input(state.range(0));
+    AllocationCounter allocations(state);
+    for (auto _ : state) {
+        Bencode output = Bencode::ParseParallel(input);
+        benchmark::DoNotOptimize(output);
+    }
+    state.SetBytesProcessed(state.iterations() * input.size());
+}
+BENCHMARK(BM_ParseParallel)->Arg(200'000)->UseRealTime();
+
+static void BM_Validate(benchmark::State& state) {
+    std::string input = file_list_input(state.range(0));
+    AllocationCounter allocations(state);
+    for (auto _ : state)
+        benchmark::DoNotOptimize(Bencode::Validate(input));
+    state.SetBytesProcessed(state.iterations() * input.size());
+}
+BENCHMARK(BM_Validate)->Arg(1'000)->Arg(200'000);
+
+// Truncated copies of a tracker response, as a crawler often receives
+static std::vector<std::string> truncated_inputs() {
+    std::string input = tracker_response_input(20);
+    std::vector<std::string> inputs {};
+    for (std::size_t size = 1; size < input.size(); size += 37)
+        inputs.push_back(input.substr(0, size));
+    return inputs;
+}
+
+static void BM_ParseTruncated(benchmark::State& state) {
+    std::vector<std::string> inputs = truncated_inputs();
+    AllocationCounter allocations(state);
+    for (auto _ : state) {
+        for (const std::string& input : inputs) {
+            try {
+                benchmark::DoNotOptimize(Bencode::Parse(input));
+            } catch (const Bencode::ParseError& e) {
+                benchmark::DoNotOptimize(e.id_);
+            }
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * inputs.size());
+}
+BENCHMARK(BM_ParseTruncated);
+
+static void BM_TryParseTruncated(benchmark::State& state) {
+    std::vector<std::string> inputs = truncated_inputs();
+    AllocationCounter allocations(state);
+    for (auto _ : state)
+        for (const std::string& input : inputs)
+            benchmark::DoNotOptimize(Bencode::TryParse(input));
+    state.SetItemsProcessed(state.iterations() * inputs.size());
+}
+BENCHMARK(BM_TryParseTruncated);
+
+static void BM_ParseTrackerResponse(benchmark::State& state) {
+    std::string input = tracker_response_input(state.range(0));
+    AllocationCounter allocations(state);
+    for (auto _ : state) {
+        std::pmr::monotonic_buffer_resource arena(input.size());
+        Bencode output = Bencode::Parse(input, arena);
+        benchmark::DoNotOptimize(output);
+    }
+    state.SetBytesProcessed(state.iterations() * input.size());
+}
+BENCHMARK(BM_ParseTrackerResponse)->Arg(200)->Arg(10'000);
+
+// Fields of tracker_response_input for the schema decoder
+class TrackerError: public std::exception {
+public:
+    enum class ExceptionID {
+        kMalformed
+    };
+    TrackerError(ExceptionID) {}
+};
+
+struct TrackerPeer {
+    std::string_view ip;
+    std::string_view peer_id;
+    long port;
+};
+
+struct TrackerResponse {
+    long interval;
+    std::vector<TrackerPeer> peers;
+};
+
+template <>
+struct BencodeSchema<TrackerPeer> {
+    using Error = TrackerError;
+    static constexpr auto kMalformed = Error::ExceptionID::kMalformed;
+    static constexpr std::tuple fields {
+        BencodeField<&TrackerPeer::ip>("ip", kMalformed, kMalformed),
+        BencodeField<&TrackerPeer::peer_id>("peer id", kMalformed, kMalformed),
+        BencodeField<&TrackerPeer::port>("port", kMalformed, kMalformed)
+    };
+};
+
+template <>
+struct BencodeSchema<TrackerResponse> {
+    using Error = TrackerError;
+    static constexpr auto kMalformed = Error::ExceptionID::kMalformed;
+    static constexpr std::tuple fields {
+        BencodeField<&TrackerResponse::interval>("interval", kMalformed,
+                                                 kMalformed),
+        BencodeField<&TrackerResponse::peers>("peers", kMalformed, kMalformed)
+    };
+};
+
+static void BM_DecodeTrackerResponse(benchmark::State& state) {
+    std::string input = tracker_response_input(state.range(0));
+    AllocationCounter allocations(state);
+    for (auto _ : state) {
+        TrackerResponse output = BencodeDecode<TrackerResponse>(
+            input, TrackerError::ExceptionID::kMalformed);
+        benchmark::DoNotOptimize(output);
+    }
+    state.SetBytesProcessed(state.iterations() * input.size());
+}
+BENCHMARK(BM_DecodeTrackerResponse)->Arg(200)->Arg(10'000);
+
+static void BM_ParseIntegerList(benchmark::State& state) {
+    std::string input = integer_list_input(state.range(0));
+    AllocationCounter allocations(state);
+    for (auto _ : state) {
+        std::pmr::monotonic_buffer_resource arena(input.size());
+        Bencode output = Bencode::Parse(input, arena);
+        benchmark::DoNotOptimize(output);
+    }
+    state.SetBytesProcessed(state.iterations() * input.size());
+}
+BENCHMARK(BM_ParseIntegerList)->Arg(100'000);
+
+static void BM_ParseSingleFileTorrent(benchmark::State& state) {
+    std::string input = single_file_torrent_input(state.range(0));
+    AllocationCounter allocations(state);
+    for (auto _ : state) {
+        Bencode output = Bencode::Parse(std::string_view(input));
+        benchmark::DoNotOptimize(output);
+    }
+    state.SetBytesProcessed(state.iterations() * input.size());
+}
+BENCHMARK(BM_ParseSingleFileTorrent)->Arg(1'000'000);
+
+static void BM_ParseNestedList(benchmark::State& state) {
+    std::string input = nested_list_input(state.range(0));
+    AllocationCounter allocations(state);
+    for (auto _ : state) {
+        Bencode output = Bencode::Parse(input, state.range(0) + 1);
+        benchmark::DoNotOptimize(output);
+    }
+    state.SetBytesProcessed(state.iterations() * input.size());
+}
+BENCHMARK(BM_ParseNestedList)->Arg(256)->Arg(100'000);
+
+static void BM_IndexBuild(benchmark::State& state) {
+    std::string input = file_list_input(state.range(0));
+    AllocationCounter allocations(state);
+    for (auto _ : state) {
+        BencodeIndex index = BencodeIndex::Build(input);
+        benchmark::DoNotOptimize(index);
+    }
+    state.SetBytesProcessed(state.iterations() * input.size());
+}
+BENCHMARK(BM_IndexBuild)->Arg(1'000)->Arg(200'000);
+
+static void BM_IndexMaterialize(benchmark::State& state) {
+    std::string input = file_list_input(state.range(0));
+    AllocationCounter allocations(state);
+    for (auto _ : state) {
+        Bencode output = BencodeIndex::Build(input).Materialize();
+        benchmark::DoNotOptimize(output);
+    }
+    state.SetBytesProcessed(state.iterations() * input.size());
+}
+BENCHMARK(BM_IndexMaterialize)->Arg(1'000)->Arg(200'000);
+
+// Reads the fields after the file list without building it
+static void BM_IndexFindPieces(benchmark::State& state) {
+    std::string input = file_list_input(state.range(0));
+    AllocationCounter allocations(state);
+    for (auto _ : state) {
+        BencodeIndex index = BencodeIndex::Build(input);
+        benchmark::DoNotOptimize(index.get_string(index.find(0, "pieces")));
+        benchmark::DoNotOptimize(index.get_int(index.find(0, "piece length")));
+    }
+    state.SetBytesProcessed(state.iterations() * input.size());
+}
+BENCHMARK(BM_IndexFindPieces)->Arg(1'000)->Arg(200'000);
+
+// Reads the fields after the file list without decoding it
+static void BM_LazyFindPieces(benchmark::State& state) {
+    std::string input = file_list_input(state.range(0));
+    AllocationCounter allocations(state);
+    for (auto _ : state) {
+        BencodeLazyView info = BencodeLazyView::Parse(input);
+        benchmark::DoNotOptimize(info.at("pieces").get_string());
+        benchmark::DoNotOptimize(info.at("piece length").get_int());
+    }
+    state.SetBytesProcessed(state.iterations() * input.size());
+}
+BENCHMARK(BM_LazyFindPieces)->Arg(1'000)->Arg(200'000);
+
+static void BM_DictLookup(benchmark::State& state) {
+    Bencode info = Bencode::Parse(
+        std::string_view(file_list_input(state.range(0))));
+    const Bencode& files = info.at("files");
+    AllocationCounter allocations(state);
+    for (auto _ : state) {
+        long total_length = 0;
+        for (const Bencode& file : files)
+            total_length += file.at("length").get_int();
+        benchmark::DoNotOptimize(total_length);
+        benchmark::DoNotOptimize(info.at("pieces"));
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_DictLookup)->Arg(1'000)->Arg(200'000);
+
+static void BM_DictIterate(benchmark::State& state) {
+    Bencode response = Bencode::Parse(
+        std::string_view(tracker_response_input(state.range(0))));
+    const Bencode& peers = response.at("peers");
+    AllocationCounter allocations(state);
+    for (auto _ : state) {
+        std::size_t key_bytes = 0;
+        for (const Bencode& peer : peers)
+            for (const auto& [key, value] : peer.items())
+                key_bytes += key.str().size();
+        benchmark::DoNotOptimize(key_bytes);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_DictIterate)->Arg(200)->Arg(10'000);
+
+static void BM_Dump(benchmark::State& state) {
+    std::string input = file_list_input(state.range(0));
+    Bencode info = Bencode::Parse(std::string_view(input));
+    AllocationCounter allocations(state);
+    for (auto _ : state) {
+        std::string output = info.Dump();
+        benchmark::DoNotOptimize(output);
+    }
+    state.SetBytesProcessed(state.iterations() * input.size());
+}
+BENCHMARK(BM_Dump)->Arg(1'000)->Arg(200'000);
+
+static void BM_DumpToReusedBuffer(benchmark::State& state) {
+    std::string input = file_list_input(state.range(0));
+    Bencode info = Bencode::Parse(std::string_view(input));
+    std::string output;
+    AllocationCounter allocations(state);
+    for (auto _ : state) {
+        output.clear();
+        info.DumpTo(output);
+        benchmark::DoNotOptimize(output);
+    }
+    state.SetBytesProcessed(state.iterations() * input.size());
+}
+BENCHMARK(BM_DumpToReusedBuffer)->Arg(1'000)->Arg(200'000);
+
+static void BM_EncodedSize(benchmark::State& state) {
+    std::string input = file_list_input(state.range(0));
+    Bencode info = Bencode::Parse(std::string_view(input));
+    AllocationCounter allocations(state);
+    for (auto _ : state)
+        benchmark::DoNotOptimize(info.EncodedSize());
+    state.SetBytesProcessed(state.iterations() * input.size());
+}
+BENCHMARK(BM_EncodedSize)->Arg(1'000)->Arg(200'000);
+
+// Produces the document of file_list_input from scratch, first through a
+// tree and then streamed by BencodeWriter
+static void BM_BuildTreeAndDump(benchmark::State& state) {
+    std::size_t file_count = state.range(0);
+    std::string output;
+    AllocationCounter allocations(state);
+    for (auto _ : state) {
+        Bencode files = Bencode::List {};
+        for (std::size_t i = 0; i < file_count; i++)
+            files.push_back(Bencode {
+                "length", static_cast<long>(i * 1024 + 1),
+                "path", Bencode::List {"sub_dir",
+                                       std::format("file_{}.dat", i)}
+            });
+        Bencode info {
+            "files", std::move(files),
+            "name", "bench_name",
+            "piece length", 262144l,
+            "pieces", std::string(20 * 64, 'a')
+        };
+        output.clear();
+        info.DumpTo(output);
+        benchmark::DoNotOptimize(output);
+    }
+    state.SetBytesProcessed(state.iterations() * output.size());
+}
+BENCHMARK(BM_BuildTreeAndDump)->Arg(1'000)->Arg(200'000);
+
+static void BM_WriterStream(benchmark::State& state) {
+    std::size_t file_count = state.range(0);
+    std::string output;
+    std::string piece(20, 'a');
+    AllocationCounter allocations(state);
+    for (auto _ : state) {
+        output.clear();
+        BencodeWriter writer(output);
+        writer.begin_dict();
+        writer.key("files");
+        writer.begin_list();
+        for (std::size_t i = 0; i < file_count; i++) {
+            writer.begin_dict();
+            writer.key("length");
+            writer.value(static_cast<long>(i * 1024 + 1));
+            writer.key("path");
+            writer.begin_list();
+            writer.value("sub_dir");
+            writer.value(std::format("file_{}.dat", i));
+            writer.end_list();
+            writer.end_dict();
+        }
+        writer.end_list();
+        writer.key("name");
+        writer.value("bench_name");
+        writer.key("piece length");
+        writer.value(262144l);
+        writer.key("pieces");
+        writer.begin_string(20 * 64);
+        for (int i = 0; i < 64; i++)
+            writer.append_string(piece);
+        writer.end_dict();
+        writer.finish();
+        benchmark::DoNotOptimize(output);
+    }
+    state.SetBytesProcessed(state.iterations() * output.size());
+}
+BENCHMARK(BM_WriterStream)->Arg(1'000)->Arg(200'000);
+
+// Extension handshake of BEP 10 with the listen port filled in per message
+static void BM_HandshakeTreeDump(benchmark::State& state) {
+    std::string output;
+    AllocationCounter allocations(state);
+    for (auto _ : state) {
+        Bencode handshake {
+            "m", Bencode {"ut_metadata", 1l, "ut_pex", 2l},
+            "p", 6881l,
+            "reqq", 250l,
+            "v", "ftor 0.1"
+        };
+        output.clear();
+        handshake.DumpTo(output);
+        benchmark::DoNotOptimize(output);
+    }
+}
+BENCHMARK(BM_HandshakeTreeDump);
+
+static void BM_HandshakeLiteralDump(benchmark::State& state) {
+    static constexpr auto handshake = BencodeEncode([] {
+        return BencodeConst {
+            "m", BencodeConst {"ut_metadata", 1l, "ut_pex", 2l},
+            "p", BencodeSlot {},
+            "reqq", 250l,
+            "v", "ftor 0.1"
+        };
+    });
+    std::string output;
+    AllocationCounter allocations(state);
+    for (auto _ : state) {
+        output.clear();
+        handshake.DumpTo(output, 6881l);
+        benchmark::DoNotOptimize(output);
+    }
+}
+BENCHMARK(BM_HandshakeLiteralDump);
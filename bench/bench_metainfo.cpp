@@ -0,0 +1,61 @@
+#include <benchmark/benchmark.h>
+#include "../src/metainfo.h"
+#include "bench_support.h"
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+static void BM_MetainfoSingleFile(benchmark::State& state) {
+    std::string input = single_file_torrent_input(state.range(0));
+    AllocationCounter allocations(state);
+    for (auto _ : state) {
+        Metainfo output = Metainfo::FromBuffer(input);
+        benchmark::DoNotOptimize(output);
+    }
+    state.SetBytesProcessed(state.iterations() * input.size());
+}
+BENCHMARK(BM_MetainfoSingleFile)->Arg(1'000)->Arg(1'000'000);
+
+static void BM_MetainfoFileList(benchmark::State& state) {
+    std::string input = multi_file_torrent_input(state.range(0));
+    AllocationCounter allocations(state);
+    for (auto _ : state) {
+        Metainfo output = Metainfo::FromBuffer(input);
+        benchmark::DoNotOptimize(output);
+    }
+    state.SetBytesProcessed(state.iterations() * input.size());
+}
+BENCHMARK(BM_MetainfoFileList)->Arg(1'000)->Arg(200'000);
+
+// Construction through a Bencode tree, as callers holding one do
+static void BM_MetainfoFromTree(benchmark::State& state) {
+    std::string input = multi_file_torrent_input(state.range(0));
+    Bencode top = Bencode::Parse(std::string_view(input));
+    AllocationCounter allocations(state);
+    for (auto _ : state) {
+        Metainfo output(top);
+        benchmark::DoNotOptimize(output);
+    }
+    state.SetBytesProcessed(state.iterations() * input.size());
+}
+BENCHMARK(BM_MetainfoFromTree)->Arg(1'000);
+
+// A catalog of small torrents loaded on state.range(0) threads
+static void BM_MetainfoLoadBatch(benchmark::State& state) {
+    std::vector<std::string> torrents {};
+    for (std::size_t i = 0; i < 1'000; i++)
+        torrents.push_back(multi_file_torrent_input(1 + i % 16));
+    std::vector<std::string_view> buffers(torrents.begin(), torrents.end());
+    std::size_t bytes = 0;
+    for (const std::string& torrent : torrents)
+        bytes += torrent.size();
+    AllocationCounter allocations(state);
+    for (auto _ : state) {
+        auto results = Metainfo::LoadBatch(buffers, state.range(0));
+        benchmark::DoNotOptimize(results);
+    }
+    state.SetBytesProcessed(state.iterations() * bytes);
+    state.SetItemsProcessed(state.iterations() * buffers.size());
+}
+BENCHMARK(BM_MetainfoLoadBatch)->Arg(1)->Arg(4)->UseRealTime();
@@ -0,0 +1,151 @@
+#include "bench_support.h"
+#include "../src/bencode.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <format>
+#include <new>
+
+namespace {
+
+std::atomic<std::size_t> allocations {0};
+
+// Piece length of the generated torrents
+constexpr long kPieceLength = 262144;
+
+// Info dictionary with pieces sized for total_length
+Bencode torrent_info(Bencode info, long total_length) {
+    std::size_t piece_count = (total_length + kPieceLength - 1) / kPieceLength;
+    info.emplace("name", "bench_name");
+    info.emplace("piece length", kPieceLength);
+    info.emplace("pieces", std::string(20 * piece_count, 'a'));
+    return info;
+}
+
+std::string torrent_input(Bencode info) {
+    return Bencode {
+        "announce", "http://tracker.example.com:6969/announce",
+        "info", std::move(info)
+    }.Dump();
+}
+
+}
+
+// Every allocation of the benchmark binary goes through these. They are kept
+// out of line, once inlined GCC pairs the malloc or free inside with the
+// operator at the other end and raises -Wmismatched-new-delete
+[[gnu::noinline]] void* operator new(std::size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void *ptr = std::malloc(size == 0 ? 1 : size))
+        return ptr;
+    throw std::bad_alloc();
+}
+
+// std::pmr::new_delete_resource allocates through the aligned form
+[[gnu::noinline]] void* operator new(std::size_t size,
+                                     std::align_val_t alignment) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    std::size_t align = static_cast<std::size_t>(alignment);
+    std::size_t rounded = (size + align - 1) / align * align;
+    if (void *ptr = std::aligned_alloc(align, rounded == 0 ? align : rounded))
+        return ptr;
+    throw std::bad_alloc();
+}
+
+[[gnu::noinline]] void operator delete(void *ptr) noexcept {
+    std::free(ptr);
+}
+
+[[gnu::noinline]] void operator delete(void *ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
+
+[[gnu::noinline]] void operator delete(void *ptr,
+                                       std::align_val_t) noexcept {
+    std::free(ptr);
+}
+
+[[gnu::noinline]] void operator delete(void *ptr, std::size_t,
+                                       std::align_val_t) noexcept {
+    std::free(ptr);
+}
+
+
+std::string file_list_input(std::size_t file_count) {
+    Bencode files = Bencode::List {};
+    for (std::size_t i = 0; i < file_count; i++)
+        files.push_back(Bencode {
+            "length", static_cast<long>(i * 1024 + 1),
+            "path", Bencode::List {"sub_dir", std::format("file_{}.dat", i)}
+        });
+    Bencode info {
+        "files", files,
+        "name", "bench_name",
+        "piece length", 262144l,
+        "pieces", std::string(20 * 64, 'a')
+    };
+    return info.Dump();
+}
+
+std::string tracker_response_input(std::size_t peer_count) {
+    Bencode peers = Bencode::List {};
+    for (std::size_t i = 0; i < peer_count; i++)
+        peers.push_back(Bencode {
+            "ip", std::format("10.0.{}.{}", i / 256 % 256, i % 256),
+            "peer id", std::string(20, 'p'),
+            "port", static_cast<long>(6881 + i % 1000)
+        });
+    Bencode response {
+        "complete", static_cast<long>(peer_count / 2),
+        "downloaded", 123456789l,
+        "incomplete", static_cast<long>(peer_count - peer_count / 2),
+        "interval", 1800l,
+        "min interval", 900l,
+        "peers", peers
+    };
+    return response.Dump();
+}
+
+std::string integer_list_input(std::size_t count) {
+    Bencode list = Bencode::List {};
+    long value = 7;
+    for (std::size_t i = 0; i < count; i++) {
+        list.push_back(i % 2 == 0 ? value : -value);
+        value = value < 100'000'000'000'000'000l ? value * 10 + 3 : 7;
+    }
+    return list.Dump();
+}
+
+std::string nested_list_input(std::size_t depth) {
+    return std::string(depth, 'l') + "i1e" + std::string(depth, 'e');
+}
+
+std::string single_file_torrent_input(std::size_t piece_count) {
+    long length = static_cast<long>(piece_count) * kPieceLength;
+    return torrent_input(torrent_info(Bencode {"length", length}, length));
+}
+
+std::string multi_file_torrent_input(std::size_t file_count) {
+    Bencode files = Bencode::List {};
+    long total_length = 0;
+    for (std::size_t i = 0; i < file_count; i++) {
+        long length = static_cast<long>(i * 1024 + 1);
+        files.push_back(Bencode {
+            "length", length,
+            "path", Bencode::List {"sub_dir", std::format("file_{}.dat", i)}
+        });
+        total_length += length;
+    }
+    return torrent_input(
+        torrent_info(Bencode {"files", std::move(files)}, total_length));
+}
+
+
+AllocationCounter::AllocationCounter(benchmark::State& state)
+    : state_(state), start_(allocations.load(std::memory_order_relaxed)) {}
+
+AllocationCounter::~AllocationCounter() {
+    std::size_t count = allocations.load(std::memory_order_relaxed) - start_;
+    state_.counters["allocs_per_op"] = benchmark::Counter(
+        static_cast<double>(count), benchmark::Counter::kAvgIterations);
+}
@@ -0,0 +1,37 @@
+#ifndef _BENCH_SUPPORT_H
+#define _BENCH_SUPPORT_H
+
+#include <benchmark/benchmark.h>
+
+#include <cstddef>
+#include <string>
+
+// Generated corpora. Each is a pure function of its arguments, so runs on
+// different machines measure the same bytes.
+
+// Info dictionary of a multi-file torrent with file_count entries
+std::string file_list_input(std::size_t file_count);
+// Tracker announce response with the dictionary peer list of BEP 3
+std::string tracker_response_input(std::size_t peer_count);
+// List of integers with one to eighteen digits
+std::string integer_list_input(std::size_t count);
+// Lists nested depth levels deep, the innermost holding an integer
+std::string nested_list_input(std::size_t depth);
+// Complete torrents that Metainfo accepts
+std::string single_file_torrent_input(std::size_t piece_count);
+std::string multi_file_torrent_input(std::size_t file_count);
+
+// Reports the heap allocations made between construction and destruction
+// as the allocs_per_op counter. Construct it after the setup of the
+// benchmark so that only the timed loop is counted.
+class AllocationCounter {
+public:
+    explicit AllocationCounter(benchmark::State& state);
+    ~AllocationCounter();
+
+private:
+    benchmark::State& state_;
+    std::size_t start_;
+};
+
+#endif // _BENCH_SUPPORT_H
@@ -2,13 +2,22 @@
 
 #include <format>
 #include <algorithm>
+#include <charconv>
+#include <iterator>
+#include <limits>
+
+#include "bencode_reader.h"
+#include "mapped_file.h"
+#include "parallel_for.h"
 
 Bencode::Bencode() {}
-Bencode::Bencode(std::string value) : data_(value) {}
-Bencode::Bencode(const char* raw_string) : data_(std::string(raw_string)) {}
+Bencode::Bencode(std::string value) : data_(std::pmr::string(value)) {}
+Bencode::Bencode(std::pmr::string value) : data_(std::move(value)) {}
+Bencode::Bencode(const char* raw_string)
+    : data_(std::pmr::string(raw_string)) {}
 Bencode::Bencode(long value) : data_(value) {}
-Bencode::Bencode(List value) : data_(value) {}
-Bencode::Bencode(Dict value) : data_(value) {}
+Bencode::Bencode(List value) : data_(std::move(value)) {}
+Bencode::Bencode(Dict value) : data_(std::move(value)) {}
 Bencode::Bencode(std::initializer_list<Bencode> init) {
     bool construct_dict = true;
     if (init.size() % 2 == 1)
@@ -20,33 +29,399 @@ Bencode::Bencode(std::initializer_list<Bencode> init) {
         }
     }
 
+    // Elements of an initializer list are const, each is copied once
     if (construct_dict) {
         Dict data {};
-        for (auto it = init.begin(); it != init.end(); it+=2)
-            data[std::get<std::string>(it->data_)] = *(it+1);
-        data_ = data;
+        data.reserve(init.size() / 2);
+        for (auto it = init.begin(); it != init.end(); it+=2) {
+            std::string_view key = std::get<std::pmr::string>(it->data_);
+            data.emplace(key, *(it+1));
+        }
+        data_ = std::move(data);
     }
     else
         data_ = List(init.begin(), init.end());
 }
 
 
-Bencode Bencode::Parse(std::istream& input) {
+Bencode Bencode::Parse(std::istream& input, std::size_t max_depth) {
+    std::string buffer(std::istreambuf_iterator<char>(input),
+                       std::istreambuf_iterator<char> {});
+    return Parse(std::string_view(buffer), max_depth);
+}
+
+Bencode Bencode::Parse(std::string_view input, std::size_t max_depth) {
+    return Parse(input, *std::pmr::get_default_resource(), max_depth);
+}
+
+Bencode Bencode::Parse(std::string_view input,
+                       std::pmr::memory_resource& resource,
+                       std::size_t max_depth) {
+    KeyTable keys {};
+    return Parse(input, resource, keys, max_depth);
+}
+
+Bencode Bencode::Parse(std::string_view input,
+                       std::pmr::memory_resource& resource,
+                       KeyTable& keys,
+                       std::size_t max_depth) {
+    std::expected<Bencode, ParseFailure> parsed =
+        TryParse(input, resource, keys, max_depth);
+    if (!parsed)
+        throw ParseError(parsed.error().id);
+    return std::move(*parsed);
+}
+
+std::expected<Bencode, Bencode::ParseFailure> Bencode::TryParse(
+        std::string_view input, std::size_t max_depth) {
+    return TryParse(input, *std::pmr::get_default_resource(), max_depth);
+}
+
+std::expected<Bencode, Bencode::ParseFailure> Bencode::TryParse(
+        std::string_view input, std::pmr::memory_resource& resource,
+        std::size_t max_depth) {
+    KeyTable keys {};
+    return TryParse(input, resource, keys, max_depth);
+}
+
+std::expected<Bencode, Bencode::ParseFailure> Bencode::TryParse(
+        std::string_view input, std::pmr::memory_resource& resource,
+        KeyTable& keys, std::size_t max_depth) {
     Bencode root_elem {};
-    if (input.peek() == EOF)
+    if (input.empty())
         return root_elem;
 
-    root_elem = ParseRecursive(input);
+    const char *origin = input.data();
+    std::expected<void, ParseFailure> parsed =
+        ParseIterative(input, root_elem, resource, keys, max_depth, origin);
+    if (!parsed)
+        return std::unexpected(parsed.error());
 
-    if (input.peek() != EOF)
-        throw ParseError(ParseError::ExceptionID::kTooMuchData);
+    if (!input.empty())
+        return std::unexpected(ParseFailure {
+            ParseError::ExceptionID::kTooMuchData,
+            static_cast<std::size_t>(input.data() - origin)
+        });
 
     return root_elem;
 }
 
-Bencode Bencode::ParseRecursive(std::istream& input) {
-    Bencode elem {};
-    switch (input.peek()) {
+Bencode Bencode::ParseFile(const std::filesystem::path& path,
+                           std::size_t max_depth) {
+    MappedFile file(path);
+    return Parse(file.data(), max_depth);
+}
+
+// Containers smaller than this are parsed whole by a single thread
+static constexpr std::size_t kParallelGrain = 64 * 1024;
+// Only the root and the two levels below it are split, enough to reach the
+// file list of a torrent
+static constexpr std::size_t kSplitDepth = 3;
+
+// Large container near the root, built by the calling thread
+struct Bencode::SplitNode {
+    std::size_t begin;
+    std::size_t end;
+    // Offsets of the first byte of each child, keys included
+    std::vector<std::size_t> children;
+};
+
+// Value inside a split container, parsed whole by a worker into its slot
+struct Bencode::Slice {
+    std::size_t begin;
+    std::size_t end;
+    std::size_t depth;
+    Bencode *slot;
+};
+
+Bencode Bencode::ParseParallel(std::string_view input,
+                               std::size_t thread_count,
+                               std::size_t max_depth) {
+    thread_count = ResolveThreadCount(thread_count);
+    std::size_t grain = std::max(kParallelGrain,
+                                 input.size() / (thread_count * 8));
+    if (thread_count == 1 || input.size() < grain)
+        return Parse(input, max_depth);
+
+    // The skim checks the whole document in the order of Parse, so the
+    // workers below only build values that are known to be valid
+    std::expected<SplitNodes, ParseFailure> nodes =
+        Skim(input, grain, max_depth);
+    if (!nodes)
+        throw ParseError(nodes.error().id);
+    if (!nodes->contains(0))
+        return Parse(input, max_depth);
+
+    Bencode root_elem {};
+    std::vector<Slice> slices {};
+    KeyTable split_keys {};
+    BuildSplit(input, *nodes, 0, 0, root_elem, split_keys, slices);
+
+    std::size_t batch = std::max<std::size_t>(
+        1, slices.size() / (thread_count * 16));
+    ParallelFor(slices.size(), thread_count, batch, [&]() {
+        return [&, keys = KeyTable {}](std::size_t i) mutable {
+            const Slice& slice = slices[i];
+            std::string_view rest = input.substr(
+                slice.begin, slice.end - slice.begin);
+            auto parsed = ParseIterative(
+                rest, *slice.slot, *std::pmr::get_default_resource(), keys,
+                max_depth - slice.depth, input.data());
+            if (!parsed)
+                throw ParseError(parsed.error().id);
+        };
+    });
+    return root_elem;
+}
+
+std::expected<Bencode::SplitNodes, Bencode::ParseFailure> Bencode::Skim(
+        std::string_view input, std::size_t grain, std::size_t max_depth) {
+    // Walks the document with a BencodeReader, which checks every rule of
+    // Parse, and records the children of large containers above
+    // kSplitDepth
+    struct Frame {
+        std::size_t begin;
+        std::vector<std::size_t> children;
+    };
+    std::vector<Frame> stack(kSplitDepth);
+    // Whether each open container is a dictionary
+    std::vector<bool> dicts {};
+    SplitNodes nodes {};
+    BencodeReader reader(input, max_depth);
+    std::string_view key;
+    auto fail = [&](ParseError::ExceptionID id) {
+        return std::unexpected(ParseFailure {id, reader.offset()});
+    };
+
+    while (true) {
+        BencodeReader::Result<ValueType> type = reader.try_peek();
+        if (!type)
+            return fail(type.error());
+        std::size_t offset = reader.offset();
+        BencodeReader::Result<void> read {};
+        switch (*type) {
+        case ValueType::kNull:
+            return fail(ParseError::ExceptionID::kUnexpectedEOF);
+        case ValueType::kString:
+            if (auto string = reader.try_read_string(); !string)
+                return fail(string.error());
+            break;
+        case ValueType::kInteger:
+            if (auto integer = reader.try_read_int(); !integer)
+                return fail(integer.error());
+            break;
+        case ValueType::kList:
+        case ValueType::kDictionary: {
+            bool dict = *type == ValueType::kDictionary;
+            read = dict ? reader.try_begin_dict() : reader.try_begin_list();
+            if (!read)
+                return fail(read.error());
+            if (dicts.size() < kSplitDepth) {
+                stack[dicts.size()].begin = offset;
+                stack[dicts.size()].children.clear();
+            }
+            dicts.push_back(dict);
+            break;
+        }
+        }
+
+        // Close finished containers and find the next value
+        bool more = false;
+        while (!more && !dicts.empty()) {
+            std::size_t next = reader.offset();
+            BencodeReader::Result<bool> step = dicts.back()
+                ? reader.try_next_key(key) : reader.try_next_element();
+            if (!step)
+                return fail(step.error());
+
+            std::size_t depth = dicts.size();
+            if (!*step) {
+                dicts.pop_back();
+                Frame& frame = stack[std::min(depth, kSplitDepth) - 1];
+                if (depth <= kSplitDepth
+                        && reader.offset() - frame.begin >= grain) {
+                    nodes.emplace(frame.begin, SplitNode {
+                        frame.begin, reader.offset(),
+                        std::move(frame.children)
+                    });
+                    frame.children.clear();
+                }
+                continue;
+            }
+
+            more = true;
+            if (depth <= kSplitDepth) {
+                // A key and its value are both children
+                stack[depth - 1].children.push_back(next);
+                if (dicts.back())
+                    stack[depth - 1].children.push_back(reader.offset());
+            }
+        }
+
+        if (!more)
+            break;
+    }
+
+    if (auto finished = reader.try_finish(); !finished)
+        return fail(finished.error());
+    return nodes;
+}
+
+void Bencode::BuildSplit(std::string_view input, const SplitNodes& nodes,
+                         std::size_t begin, std::size_t depth,
+                         Bencode& target, KeyTable& keys,
+                         std::vector<Slice>& slices) {
+    const SplitNode& node = nodes.at(begin);
+    const std::vector<std::size_t>& children = node.children;
+    std::pmr::memory_resource& resource = *std::pmr::get_default_resource();
+    target.source_ = SourceRange {node.begin, node.end};
+    auto child_end = [&](std::size_t idx) {
+        return idx + 1 < children.size() ? children[idx + 1] : node.end - 1;
+    };
+    // Slots are reserved up front, so workers may fill them in any order
+    auto place = [&](std::size_t idx, Bencode& slot) {
+        if (nodes.contains(children[idx]))
+            BuildSplit(input, nodes, children[idx], depth + 1, slot, keys,
+                       slices);
+        else
+            slices.push_back(
+                Slice {children[idx], child_end(idx), depth + 1, &slot});
+    };
+
+    if (input[begin] == 'l') {
+        List& list = target.data_.emplace<List>(&resource);
+        list.reserve(children.size());
+        for (std::size_t i = 0; i < children.size(); i++)
+            place(i, list.emplace_back());
+        return;
+    }
+
+    // The skim has checked the keys, they only need to be read
+    Dict& dict = target.data_.emplace<Dict>(&resource);
+    dict.reserve(children.size() / 2);
+    for (std::size_t i = 0; i < children.size(); i += 2) {
+        std::string_view rest = input.substr(children[i]);
+        place(i + 1, dict.append(keys.intern(ReadKey(rest))));
+    }
+}
+
+std::expected<void, Bencode::ParseFailure> Bencode::ParseIterative(
+        std::string_view& input, Bencode& root_elem,
+        std::pmr::memory_resource& resource, KeyTable& keys,
+        std::size_t max_depth, const char *origin) {
+    // Containers are filled in place: each frame points at a node that
+    // already sits in its parent, so finished children are never copied
+    // or moved up. Only the innermost container grows, which keeps the
+    // pointers held by the outer frames valid.
+    struct Frame {
+        Bencode *node;
+        std::string_view previous_key;
+        bool bad_order;
+        bool duplicate_keys;
+    };
+    std::vector<Frame> stack {};
+    Bencode *target = &root_elem;
+    auto offset = [&]() -> std::size_t { return input.data() - origin; };
+    auto fail = [&](ParseError::ExceptionID id) {
+        return std::unexpected(ParseFailure {id, offset()});
+    };
+
+    while (true) {
+        if (input.empty())
+            return fail(ParseError::ExceptionID::kUnexpectedEOF);
+
+        // Containers get their end offset when they are closed
+        target->source_ = SourceRange {offset(), 0};
+        switch (input.front()) {
+        case '0':
+        case '1':
+        case '2':
+        case '3':
+        case '4':
+        case '5':
+        case '6':
+        case '7':
+        case '8':
+        case '9':
+        case '-': {
+            auto string = TryReadString(input);
+            if (!string)
+                return fail(string.error());
+            target->data_.emplace<std::pmr::string>(*string, &resource);
+            target->source_.end = offset();
+            break;
+        }
+        case 'i': {
+            auto integer = TryReadInteger(input);
+            if (!integer)
+                return fail(integer.error());
+            target->data_ = *integer;
+            target->source_.end = offset();
+            break;
+        }
+        case 'l':
+        case 'd':
+            if (stack.size() >= max_depth)
+                return fail(ParseError::ExceptionID::kNestingTooDeep);
+            if (input.front() == 'l')
+                target->data_.emplace<List>(&resource);
+            else
+                target->data_.emplace<Dict>(&resource);
+            input.remove_prefix(1);  // Ignore l or d
+            stack.push_back(Frame {target, {}, false, false});
+            break;
+        default:
+            return fail(ParseError::ExceptionID::kBadPrefix);
+        }
+
+        // Close finished containers and find the slot for the next value
+        target = nullptr;
+        while (target == nullptr && !stack.empty()) {
+            Frame& frame = stack.back();
+            if (input.empty())
+                return fail(ParseError::ExceptionID::kUnexpectedEOF);
+
+            if (input.front() == 'e') {
+                if (frame.bad_order)
+                    return fail(ParseError::ExceptionID::kDictBadOrder);
+                if (frame.duplicate_keys)
+                    return fail(ParseError::ExceptionID::kDictDuplicateKeys);
+                input.remove_prefix(1);  // Ignore e
+                frame.node->source_.end = offset();
+                stack.pop_back();
+            }
+            else if (frame.node->Type() == ValueType::kList) {
+                List& list = std::get<List>(frame.node->data_);
+                target = &list.emplace_back();
+            }
+            else {
+                Dict& dict = std::get<Dict>(frame.node->data_);
+                auto read_key = TryReadKey(input);
+                if (!read_key)
+                    return fail(read_key.error());
+                std::string_view key = *read_key;
+                if (!dict.empty() && key < frame.previous_key)
+                    frame.bad_order = true;
+                else if (!dict.empty() && key == frame.previous_key)
+                    frame.duplicate_keys = true;
+                frame.previous_key = key;
+
+                if (!input.empty() && input.front() == 'e')
+                    return fail(ParseError::ExceptionID::kDictIncompletePair);
+                // Out of order keys are appended too, the frame fails on
+                // its postfix before the dictionary is ever looked up
+                target = &dict.append(keys.intern(key));
+            }
+        }
+
+        if (target == nullptr)
+            return {};
+    }
+}
+
+std::expected<std::string_view, Bencode::ReadError> Bencode::TryReadKey(
+        std::string_view& input) {
+    switch (input.front()) {
     case '0':
     case '1':
     case '2':
@@ -58,150 +433,309 @@ Bencode Bencode::ParseRecursive(std::istream& input) {
     case '8':
     case '9':
     case '-':
-        elem = ParseString(input);
-        break;
+        return TryReadString(input);
     case 'i':
-        elem = ParseInteger(input);
-        break;
     case 'l':
-        elem = ParseList(input);
-        break;
     case 'd':
-        elem = ParseDictionary(input);
-        break;
-    case EOF:
-        throw ParseError(ParseError::ExceptionID::kUnexpectedEOF);
+        return std::unexpected(ReadError::kDictKeyNotString);
     default:
-        throw ParseError(ParseError::ExceptionID::kBadPrefix);
+        return std::unexpected(ReadError::kBadPrefix);
     }
-
-    return elem;
 }
 
-Bencode Bencode::ParseString(std::istream& input) {
-    std::size_t string_length;
-    if (input.peek() == '-')
-        throw ParseError(ParseError::ExceptionID::kNegativeStringLength);
-    else if (input.peek() == '0') {
-        input.ignore();
-        if (input.peek() >= '0' && input.peek() <= '9')
-            throw ParseError(ParseError::ExceptionID::kLeading0);
-        string_length = 0;
-    } else
-        input >> string_length;
-
-    if (input.get() != ':')
-        throw ParseError(ParseError::ExceptionID::kStringMissingColon);
-
-    std::string string(string_length, '\0');
-    input.read(string.data(), string_length);
-    if (input.gcount() != string_length)
-        throw ParseError(ParseError::ExceptionID::kUnexpectedEOF);
+// Result of scanning the run of decimal digits at the front of a buffer
+struct DigitScan {
+    std::size_t digits;
+    unsigned long value;
+    bool leading_zero;
+    bool overflow;
+};
+
+// Reads the digits, their value and both error conditions in one pass.
+// Nineteen digits always fit in 64 bits, so the loop only multiplies and
+// adds; anything longer overflows every limit used by the parser.
+static DigitScan ScanDigits(std::string_view input, unsigned long limit) {
+    static_assert(sizeof(unsigned long) == 8);
+    constexpr std::size_t kSafeDigits = 19;
+
+    const char *begin = input.data();
+    const char *end = begin + std::min(input.size(), kSafeDigits);
+    const char *it = begin;
+    unsigned long value = 0;
+    while (it != end) {
+        unsigned char digit = static_cast<unsigned char>(*it - '0');
+        if (digit > 9)
+            break;
+        value = value * 10 + digit;
+        ++it;
+    }
 
-    return Bencode(string);
+    std::size_t digits = it - begin;
+    bool longer = digits == kSafeDigits && input.size() > kSafeDigits
+        && static_cast<unsigned char>(input[kSafeDigits] - '0') <= 9;
+    return DigitScan {
+        digits,
+        value,
+        digits > 1 && *begin == '0',
+        longer || value > limit
+    };
 }
 
-Bencode Bencode::ParseInteger(std::istream& input) {
-    input.ignore();  // Ignore i
+std::expected<std::string_view, Bencode::ReadError> Bencode::TryReadString(
+        std::string_view& input) {
+    if (input.front() == '-')
+        return std::unexpected(ReadError::kNegativeStringLength);
+
+    DigitScan scan = ScanDigits(input, std::numeric_limits<std::size_t>::max());
+    if (scan.leading_zero)
+        return std::unexpected(ReadError::kLeading0);
+    // No buffer holds that many bytes
+    if (scan.overflow)
+        return std::unexpected(ReadError::kUnexpectedEOF);
+    input.remove_prefix(scan.digits);
+
+    if (input.empty() || input.front() != ':')
+        return std::unexpected(ReadError::kStringMissingColon);
+    input.remove_prefix(1);
+
+    std::size_t string_length = scan.value;
+    if (input.size() < string_length)
+        return std::unexpected(ReadError::kUnexpectedEOF);
+
+    std::string_view string = input.substr(0, string_length);
+    input.remove_prefix(string_length);
+    return string;
+}
 
-    switch (input.peek()) {
-    case EOF:
-        throw ParseError(ParseError::ExceptionID::kUnexpectedEOF);
-    case 'e':
-        throw ParseError(ParseError::ExceptionID::kIntegerEmpty);
-    case '-':
-    case '0':
-    case '1':
-    case '2':
-    case '3':
-    case '4':
-    case '5':
-    case '6':
-    case '7':
-    case '8':
-    case '9':
-        break;
-    default:
-        throw ParseError(ParseError::ExceptionID::kIntegerNonDecimal);
-    }
+std::expected<long, Bencode::ReadError> Bencode::TryReadInteger(
+        std::string_view& input) {
+    input.remove_prefix(1);  // Ignore i
 
-    long number;
-    input >> number;
+    if (input.empty())
+        return std::unexpected(ReadError::kUnexpectedEOF);
+    else if (input.front() == 'e')
+        return std::unexpected(ReadError::kIntegerEmpty);
 
-    if (input.peek() == EOF)
-        throw ParseError(ParseError::ExceptionID::kUnexpectedEOF);
-    else if (input.peek() != 'e')
-        throw ParseError(ParseError::ExceptionID::kMissingPostfix);
-    input.ignore();
+    bool negative = input.front() == '-';
+    if (negative) {
+        input.remove_prefix(1);
+        if (input.empty())
+            return std::unexpected(ReadError::kUnexpectedEOF);
+    }
 
-    return Bencode(number);
+    unsigned long limit = std::numeric_limits<long>::max();
+    if (negative)
+        limit += 1;
+    DigitScan scan = ScanDigits(input, limit);
+    if (scan.digits == 0)
+        return std::unexpected(ReadError::kIntegerNonDecimal);
+    // Zero has exactly one encoding, i0e
+    if (scan.leading_zero || (negative && scan.value == 0))
+        return std::unexpected(ReadError::kLeading0);
+    if (scan.overflow)
+        return std::unexpected(ReadError::kIntegerNonDecimal);
+    input.remove_prefix(scan.digits);
+
+    if (input.empty())
+        return std::unexpected(ReadError::kUnexpectedEOF);
+    else if (input.front() != 'e')
+        return std::unexpected(ReadError::kMissingPostfix);
+    input.remove_prefix(1);
+
+    return negative ? static_cast<long>(0 - scan.value)
+                    : static_cast<long>(scan.value);
 }
 
-Bencode Bencode::ParseList(std::istream& input) {
-    input.ignore();  // Ignore l
+std::string_view Bencode::ReadKey(std::string_view& input) {
+    std::expected<std::string_view, ReadError> key = TryReadKey(input);
+    if (!key)
+        throw ParseError(key.error());
+    return *key;
+}
 
-    Bencode list_elem = List {};
-    while (input.peek() != 'e')
-        list_elem.push_back(ParseRecursive(input));
+std::string_view Bencode::ReadString(std::string_view& input) {
+    std::expected<std::string_view, ReadError> string = TryReadString(input);
+    if (!string)
+        throw ParseError(string.error());
+    return *string;
+}
 
-    input.ignore();  // Ignore e
-    return list_elem;
+long Bencode::ReadInteger(std::string_view& input) {
+    std::expected<long, ReadError> integer = TryReadInteger(input);
+    if (!integer)
+        throw ParseError(integer.error());
+    return *integer;
 }
 
-Bencode Bencode::ParseDictionary(std::istream& input) {
-    input.ignore();  // Ignore d
+void Bencode::ParseEvents(std::string_view input, EventHandler& handler,
+                          std::size_t max_depth) {
+    // Errors are reported in the order of ParseIterative
+    struct Frame {
+        bool dict;
+        std::string_view previous_key;
+        bool bad_order;
+        bool duplicate_keys;
+    };
+    std::vector<Frame> stack {};
+    if (input.empty())
+        return;
 
-    Bencode dict_elem = Dict {};
-    std::vector<std::string> key_list {};
-    while (input.peek() != 'e') {
-        Bencode key = ParseRecursive(input);
-        if (key.Type() != ValueType::kString)
-            throw ParseError(ParseError::ExceptionID::kDictKeyNotString);
-        key_list.push_back(std::get<std::string>(key.data_));
+    bool more = true;
+    while (more) {
+        if (input.empty())
+            throw ParseError(ParseError::ExceptionID::kUnexpectedEOF);
+
+        switch (input.front()) {
+        case '0':
+        case '1':
+        case '2':
+        case '3':
+        case '4':
+        case '5':
+        case '6':
+        case '7':
+        case '8':
+        case '9':
+        case '-':
+            handler.on_string(ReadString(input));
+            break;
+        case 'i':
+            handler.on_integer(ReadInteger(input));
+            break;
+        case 'l':
+        case 'd':
+            if (stack.size() >= max_depth)
+                throw ParseError(ParseError::ExceptionID::kNestingTooDeep);
+            stack.push_back(Frame {input.front() == 'd', {}, false, false});
+            input.remove_prefix(1);  // Ignore l or d
+            if (stack.back().dict)
+                handler.begin_dict();
+            else
+                handler.begin_list();
+            break;
+        default:
+            throw ParseError(ParseError::ExceptionID::kBadPrefix);
+        }
 
-        if (input.peek() == 'e')
-            throw ParseError(ParseError::ExceptionID::kDictIncompletePair);
-        dict_elem[std::get<std::string>(key.data_)] = ParseRecursive(input);
+        // Close finished containers and find the next value
+        more = false;
+        while (!more && !stack.empty()) {
+            Frame& frame = stack.back();
+            if (input.empty())
+                throw ParseError(ParseError::ExceptionID::kUnexpectedEOF);
+
+            if (input.front() == 'e') {
+                if (frame.bad_order)
+                    throw ParseError(ParseError::ExceptionID::kDictBadOrder);
+                if (frame.duplicate_keys)
+                    throw ParseError(
+                        ParseError::ExceptionID::kDictDuplicateKeys);
+                input.remove_prefix(1);  // Ignore e
+                bool dict = frame.dict;
+                stack.pop_back();
+                if (dict)
+                    handler.end_dict();
+                else
+                    handler.end_list();
+                continue;
+            }
+
+            more = true;
+            if (!frame.dict)
+                continue;
+            bool first_key = frame.previous_key.data() == nullptr;
+            std::string_view key = ReadKey(input);
+            if (!first_key && key < frame.previous_key)
+                frame.bad_order = true;
+            else if (!first_key && key == frame.previous_key)
+                frame.duplicate_keys = true;
+            frame.previous_key = key;
+            handler.key(key);
+
+            if (!input.empty() && input.front() == 'e')
+                throw ParseError(ParseError::ExceptionID::kDictIncompletePair);
+        }
     }
 
-    if (!std::is_sorted(key_list.begin(), key_list.end()))
-        throw ParseError(ParseError::ExceptionID::kDictBadOrder);
-    if (std::adjacent_find(key_list.begin(), key_list.end()) != key_list.end())
-        throw ParseError(ParseError::ExceptionID::kDictDuplicateKeys);
+    if (!input.empty())
+        throw ParseError(ParseError::ExceptionID::kTooMuchData);
+}
 
-    input.ignore();  // Ignore e
-    return dict_elem;
+std::expected<void, Bencode::ParseFailure> Bencode::Validate(
+        std::string_view input, std::size_t max_depth) {
+    if (input.empty())
+        return {};
+    BencodeReader reader(input, max_depth);
+    BencodeReader::Result<void> result = reader.try_skip();
+    if (result)
+        result = reader.try_finish();
+    if (!result)
+        return std::unexpected(ParseFailure {result.error(), reader.offset()});
+    return {};
 }
 
 std::string Bencode::Dump() const {
     std::string output;
+    DumpTo(output);
+    return output;
+}
+
+static std::size_t DecimalLength(unsigned long value) {
+    std::size_t length = 1;
+    while (value >= 10) {
+        value /= 10;
+        length++;
+    }
+    return length;
+}
 
+static std::size_t EncodedStringSize(std::string_view string) {
+    return DecimalLength(string.size()) + 1 + string.size();
+}
+
+std::size_t Bencode::EncodedSize() const {
+    std::size_t size = 0;
     switch (Type()) {
     case ValueType::kNull:
         throw DumpError(DumpError::ExceptionID::kNull);
     case ValueType::kString:
-        output = std::format("{}:{}", get_string().length(), get_string());
-        break;
-    case ValueType::kInteger:
-        output = std::format("i{}e", get_int());
-        break;
+        return EncodedStringSize(std::get<std::pmr::string>(data_));
+    case ValueType::kInteger: {
+        long value = std::get<long>(data_);
+        if (value < 0)
+            return 3 + DecimalLength(0ul - static_cast<unsigned long>(value));
+        return 2 + DecimalLength(value);
+    }
     case ValueType::kList:
-        output = "l";
-        for (const Bencode& elem : *this)
-            output += elem.Dump();
-        output.push_back('e');
-        break;
+        size = 2;
+        for (const Bencode& elem : std::get<List>(data_))
+            size += elem.EncodedSize();
+        return size;
     case ValueType::kDictionary:
-        output = "d";
-        for (const auto &[key, value] : this->items()) {
-            output += Bencode(key).Dump();
-            output += value.Dump();
-        }
-        output.push_back('e');
-        break;
+        size = 2;
+        for (const auto& [key, value] : std::get<Dict>(data_))
+            size += EncodedStringSize(key) + value.EncodedSize();
+        return size;
+    default:
+        throw std::logic_error("Unreachable state");
     }
+}
 
-    return output;
+void Bencode::DumpTo(std::string& output) const {
+    DumpToSink(output);
+}
+
+void Bencode::DumpTo(std::ostream& output) const {
+    struct {
+        void append(const char *data, std::size_t size) {
+            output.write(data, size);
+        }
+        void push_back(char c) {
+            output.put(c);
+        }
+        std::ostream& output;
+    } sink {output};
+    DumpToSink(sink);
 }
 
 
@@ -224,7 +758,7 @@ Bencode::ValueType Bencode::Type() const {
 
 
 std::string_view Bencode::get_string() const {
-    return std::get<std::string>(data_);
+    return std::get<std::pmr::string>(data_);
 }
 
 long Bencode::get_int() const {
@@ -232,11 +766,19 @@ long Bencode::get_int() const {
 }
 
 
+std::optional<Bencode::SourceRange> Bencode::source_range() const {
+    // Every encoding takes at least two bytes
+    if (source_.end == 0)
+        return std::nullopt;
+    return source_;
+}
+
+
 const Bencode& Bencode::at(std::size_t idx) const {
     return std::get<List>(data_).at(idx);
 }
 
-const Bencode& Bencode::at(const std::string& key) const {
+const Bencode& Bencode::at(std::string_view key) const {
     return std::get<Dict>(data_).at(key);
 }
 
@@ -245,38 +787,69 @@ Bencode& Bencode::operator[](std::size_t idx) {
     if (idx >= size())
         throw std::out_of_range(
             std::format("Bad index. Size: {} Got: {}", size(), idx));
+    source_ = {};
     return data[idx];
 }
 
-Bencode& Bencode::operator[](const std::string& key) {
+Bencode& Bencode::operator[](std::string_view key) {
     if (Type() == ValueType::kNull)
         data_ = Dict {};
+    source_ = {};
     return std::get<Dict>(data_)[key];
 }
 
 
-Bencode::const_iterator::const_iterator(List::const_iterator it)
-    : it_(it), type_(IteratorType::List) {}
+Bencode::const_iterator::const_iterator() {}
+
+Bencode::const_iterator::const_iterator(List::const_iterator it) : it_(it) {}
 
-Bencode::const_iterator::const_iterator(Dict::const_iterator it)
-    : it_(it), type_(IteratorType::Dictionary) {}
+Bencode::const_iterator::const_iterator(Dict::const_iterator it,
+                                        Dict::const_iterator end)
+        : it_(it), dict_end_(end) {
+    LoadKey();
+}
 
-void Bencode::const_iterator::operator++() {
-    if (type_ == IteratorType::List)
+Bencode::const_iterator& Bencode::const_iterator::operator++() {
+    if (it_.index() == 0)
         ++(std::get<List::const_iterator>(it_));
-    else
+    else {
         ++(std::get<Dict::const_iterator>(it_));
+        LoadKey();
+    }
+    return *this;
+}
+
+Bencode::const_iterator Bencode::const_iterator::operator++(int) {
+    const_iterator previous = *this;
+    ++(*this);
+    return previous;
 }
 
-bool Bencode::const_iterator::operator!=(const const_iterator& other) const {
-    return it_ != other.it_;
+bool Bencode::const_iterator::operator==(const const_iterator& other) const {
+    return it_ == other.it_;
 }
 
-Bencode Bencode::const_iterator::operator*() const {
-    if (type_ == IteratorType::List)
+const Bencode& Bencode::const_iterator::operator*() const {
+    if (it_.index() == 0)
         return *(std::get<List::const_iterator>(it_));
+    return key_;
+}
+
+void Bencode::const_iterator::LoadKey() {
+    Dict::const_iterator it = std::get<Dict::const_iterator>(it_);
+    if (it == dict_end_)
+        return;
+
+    // Assigning over the previous key reuses its storage
+    const std::string& key = it->first.str();
+    if (key_.Type() == ValueType::kString)
+        std::get<std::pmr::string>(key_.data_) = std::string_view(key);
     else
-        return std::get<Dict::const_iterator>(it_)->first;
+        key_ = key;
+}
+
+const Bencode *Bencode::const_iterator::operator->() const {
+    return &**this;
 }
 
 Bencode::const_iterator Bencode::begin() const {
@@ -284,7 +857,8 @@ Bencode::const_iterator Bencode::begin() const {
     case ValueType::kList:
         return const_iterator(std::get<List>(data_).cbegin());
     case ValueType::kDictionary:
-        return const_iterator(std::get<Dict>(data_).cbegin());
+        return const_iterator(std::get<Dict>(data_).cbegin(),
+                              std::get<Dict>(data_).cend());
     default:
         throw std::bad_variant_access();
     }
@@ -295,7 +869,8 @@ Bencode::const_iterator Bencode::end() const {
     case ValueType::kList:
         return const_iterator(std::get<List>(data_).cend());
     case ValueType::kDictionary:
-        return const_iterator(std::get<Dict>(data_).cend());
+        return const_iterator(std::get<Dict>(data_).cend(),
+                              std::get<Dict>(data_).cend());
     default:
         throw std::bad_variant_access();
     }
@@ -303,33 +878,16 @@ Bencode::const_iterator Bencode::end() const {
 
 
 Bencode::ConstIterationProxy::ConstIterationProxy(const Dict& data)
-    : data_(data) {}
+    : data_(&data) {}
 
 Bencode::ConstIterationProxy::const_iterator Bencode::ConstIterationProxy
         ::begin() const {
-    return ConstIterationProxy::const_iterator(data_.cbegin());
+    return data_->cbegin();
 }
 
 Bencode::ConstIterationProxy::const_iterator Bencode::ConstIterationProxy
         ::end() const {
-    return ConstIterationProxy::const_iterator(data_.cend());
-}
-
-Bencode::ConstIterationProxy::const_iterator
-    ::const_iterator(Dict::const_iterator it) : it_(it) {}
-
-void Bencode::ConstIterationProxy::const_iterator::operator++() {
-    ++it_;
-}
-
-bool Bencode::ConstIterationProxy::const_iterator
-    ::operator!=(const const_iterator& other) const {
-    return it_ != other.it_;
-}
-
-std::pair<std::string, Bencode> Bencode::ConstIterationProxy::const_iterator
-    ::operator*() const {
-    return *it_;
+    return data_->cend();
 }
 
 Bencode::ConstIterationProxy Bencode::items() const {
@@ -337,7 +895,7 @@ Bencode::ConstIterationProxy Bencode::items() const {
 }
 
 
-bool Bencode::contains(const std::string& key) const {
+bool Bencode::contains(std::string_view key) const {
     if (Type() != ValueType::kDictionary)
         return false;
     return std::get<Dict>(data_).contains(key);
@@ -380,11 +938,12 @@ bool Bencode::empty() const {
 
 
 void Bencode::clear() {
+    source_ = {};
     switch (Type()) {
     case ValueType::kNull:
         return;
     case ValueType::kString:
-        std::get<std::string>(data_).clear();
+        std::get<std::pmr::string>(data_).clear();
         return;
     case ValueType::kInteger:
         std::get<long>(data_) = 0;
@@ -400,8 +959,10 @@ void Bencode::clear() {
     }
 }
 
-std::size_t Bencode::erase(const std::string& key) {
-    return std::get<Dict>(data_).erase(key);
+std::size_t Bencode::erase(std::string_view key) {
+    Dict& data = std::get<Dict>(data_);
+    source_ = {};
+    return data.erase(key);
 }
 
 void Bencode::erase(std::size_t idx) {
@@ -409,13 +970,16 @@ void Bencode::erase(std::size_t idx) {
     auto it = data.begin() + idx;
     if (it == data.end())
         throw std::out_of_range("Bad index for erase");
+    source_ = {};
     data.erase(it);
 }
 
 void Bencode::push_back(Bencode elem) {
     if (Type() == ValueType::kNull)
         data_ = List {};
-    std::get<List>(data_).push_back(elem);
+    List& data = std::get<List>(data_);
+    source_ = {};
+    data.push_back(std::move(elem));
 }
 
 
@@ -424,6 +988,168 @@ bool Bencode::operator==(const Bencode& rhs) const {
 }
 
 
+Bencode::Key::Key(std::string value)
+    : data_(std::make_shared<const std::string>(std::move(value))) {}
+
+Bencode::Key::Key(std::string_view value) : Key(std::string(value)) {}
+
+Bencode::Key::Key(const char *value) : Key(std::string(value)) {}
+
+const std::string& Bencode::Key::str() const {
+    return *data_;
+}
+
+Bencode::Key::operator std::string_view() const {
+    return *data_;
+}
+
+bool operator==(const Bencode::Key& lhs, std::string_view rhs) {
+    return std::string_view(lhs) == rhs;
+}
+
+std::strong_ordering operator<=>(const Bencode::Key& lhs,
+                                 std::string_view rhs) {
+    return std::string_view(lhs) <=> rhs;
+}
+
+
+Bencode::Key Bencode::KeyTable::intern(std::string_view key) {
+    auto it = keys_.find(key);
+    if (it == keys_.end())
+        it = keys_.emplace(key).first;
+    return *it;
+}
+
+std::size_t Bencode::KeyTable::size() const {
+    return keys_.size();
+}
+
+void Bencode::KeyTable::clear() {
+    keys_.clear();
+}
+
+std::size_t Bencode::KeyTable::Hash::operator()(std::string_view key) const {
+    return std::hash<std::string_view> {}(key);
+}
+
+
+Bencode::Dict::Dict() {}
+
+Bencode::Dict::Dict(std::pmr::memory_resource *resource) : data_(resource) {}
+
+Bencode::Dict::Dict(std::initializer_list<value_type> init)
+        : data_(init.begin(), init.end()) {
+    // Like std::map, the first of several equal keys wins
+    std::stable_sort(data_.begin(), data_.end(),
+        [](const value_type& lhs, const value_type& rhs) {
+            return lhs.first < rhs.first;
+        });
+    auto last = std::unique(data_.begin(), data_.end(),
+        [](const value_type& lhs, const value_type& rhs) {
+            return lhs.first == rhs.first;
+        });
+    data_.erase(last, data_.end());
+}
+
+const Bencode& Bencode::Dict::at(std::string_view key) const {
+    auto it = lower_bound(key);
+    if (it == data_.end() || it->first != key)
+        throw std::out_of_range(std::format("Bad key: {}", key));
+    return it->second;
+}
+
+Bencode& Bencode::Dict::at(std::string_view key) {
+    auto it = lower_bound(key);
+    if (it == data_.end() || it->first != key)
+        throw std::out_of_range(std::format("Bad key: {}", key));
+    return it->second;
+}
+
+Bencode& Bencode::Dict::operator[](std::string_view key) {
+    auto it = lower_bound(key);
+    if (it == data_.end() || it->first != key)
+        it = data_.emplace(it, Key(key), Bencode {});
+    return it->second;
+}
+
+Bencode::Dict::const_iterator Bencode::Dict::begin() const {
+    return data_.cbegin();
+}
+
+Bencode::Dict::const_iterator Bencode::Dict::end() const {
+    return data_.cend();
+}
+
+Bencode::Dict::const_iterator Bencode::Dict::cbegin() const {
+    return data_.cbegin();
+}
+
+Bencode::Dict::const_iterator Bencode::Dict::cend() const {
+    return data_.cend();
+}
+
+Bencode::Dict::const_iterator Bencode::Dict::find(std::string_view key) const {
+    auto it = lower_bound(key);
+    if (it == data_.end() || it->first != key)
+        return data_.end();
+    return it;
+}
+
+bool Bencode::Dict::contains(std::string_view key) const {
+    return find(key) != data_.end();
+}
+
+std::size_t Bencode::Dict::size() const {
+    return data_.size();
+}
+
+bool Bencode::Dict::empty() const {
+    return data_.empty();
+}
+
+void Bencode::Dict::reserve(std::size_t capacity) {
+    data_.reserve(capacity);
+}
+
+void Bencode::Dict::clear() {
+    data_.clear();
+}
+
+std::size_t Bencode::Dict::erase(std::string_view key) {
+    auto it = lower_bound(key);
+    if (it == data_.end() || it->first != key)
+        return 0;
+    data_.erase(it);
+    return 1;
+}
+
+Bencode& Bencode::Dict::append(Key key) {
+    return data_.emplace_back(std::piecewise_construct,
+                              std::forward_as_tuple(std::move(key)),
+                              std::forward_as_tuple()).second;
+}
+
+bool Bencode::Dict::operator==(const Dict& rhs) const {
+    return data_ == rhs.data_;
+}
+
+Bencode::Dict::container_type::iterator
+        Bencode::Dict::lower_bound(std::string_view key) {
+    return std::lower_bound(data_.begin(), data_.end(), key,
+        [](const value_type& elem, std::string_view key) {
+            return elem.first < key;
+        });
+}
+
+Bencode::Dict::container_type::const_iterator
+        Bencode::Dict::lower_bound(std::string_view key) const {
+    return std::lower_bound(data_.begin(), data_.end(), key,
+        [](const value_type& elem, std::string_view key) {
+            return elem.first < key;
+        });
+}
+
+
 Bencode::ParseError::ParseError(ExceptionID id) : id_(id) {}
 
 const char* Bencode::ParseError::what() const noexcept {
@@ -454,6 +1180,8 @@ const char* Bencode::ParseError::what() const noexcept {
         return "syntax error - encountered duplicate keys";
     case ExceptionID::kDictBadOrder:
         return "syntax error - key-value pairs must be ordered";
+    case ExceptionID::kNestingTooDeep:
+        return "syntax error - exceeded maximum nesting depth";
     default:
         return "Bencode::ParseError::what, Not yet implemented";
     }
@@ -477,6 +1205,6 @@ std::istream& operator>>(std::istream& i, Bencode& o) {
 }
 
 std::ostream& operator<<(std::ostream& o, const Bencode& i) {
-    std::string output = i.Dump();
-    return o.write(output.data(), output.size());
+    i.DumpTo(o);
+    return o;
 }
@@ -2,19 +2,129 @@
 #define _BENCODE_H
 
 #include <vector>
-#include <map>
+#include <algorithm>
+#include <charconv>
+#include <compare>
+#include <concepts>
+#include <expected>
+#include <iterator>
+#include <memory>
+#include <memory_resource>
+#include <optional>
 #include <string>
+#include <string_view>
+#include <tuple>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
 #include <variant>
 #include <iostream>
+#include <filesystem>
 
 class Bencode {
 public:
-    using List = std::vector<Bencode>;
-    using Dict = std::map<std::string, Bencode>;
+    // Containers and strings take their memory from a
+    // std::pmr::memory_resource, the default resource unless a parse is
+    // given one. Copies always use the default resource, moves keep the
+    // resource of their source. Dictionary keys come from a KeyTable.
+    using List = std::pmr::vector<Bencode>;
+
+    // Immutable dictionary key. Copies share one string, as do the keys a
+    // KeyTable hands out, so equal keys usually compare by pointer alone.
+    class Key {
+    public:
+        Key(std::string value);
+        Key(std::string_view value);
+        Key(const char *value);
+
+        const std::string& str() const;
+        operator std::string_view() const;
+
+        friend bool operator==(const Key& lhs, std::string_view rhs);
+        friend std::strong_ordering operator<=>(const Key& lhs,
+                                                std::string_view rhs);
+        template <std::same_as<Key> K>
+        friend bool operator==(const K& lhs, const K& rhs) {
+            return lhs.data_ == rhs.data_ || *lhs.data_ == *rhs.data_;
+        }
+
+    private:
+        std::shared_ptr<const std::string> data_;
+    };
+
+    // Hands out one Key per distinct string. Parse interns into a table of
+    // its own, pass one in to share keys across documents. A table is not
+    // safe to use from several threads at once, the keys it returns are.
+    class KeyTable {
+    public:
+        Key intern(std::string_view key);
+        std::size_t size() const;
+        void clear();
+
+    private:
+        struct Hash {
+            using is_transparent = void;
+            std::size_t operator()(std::string_view key) const;
+        };
+        std::unordered_set<Key, Hash, std::equal_to<>> keys_;
+    };
+
+    // Dictionary stored as a vector of key-value pairs sorted by key.
+    // Lookups are binary searches over contiguous memory, and append()
+    // adds a key that sorts after all present keys in constant time.
+    class Dict {
+    public:
+        using value_type = std::pair<Key, Bencode>;
+        using container_type = std::pmr::vector<value_type>;
+        using const_iterator = container_type::const_iterator;
+
+        Dict();
+        explicit Dict(std::pmr::memory_resource *resource);
+        Dict(std::initializer_list<value_type> init);
+
+        // Element access
+        const Bencode& at(std::string_view key) const;
+        Bencode& at(std::string_view key);
+        Bencode& operator[](std::string_view key);
+
+        // Iteration
+        const_iterator begin() const;
+        const_iterator end() const;
+        const_iterator cbegin() const;
+        const_iterator cend() const;
+
+        // Lookup
+        const_iterator find(std::string_view key) const;
+        bool contains(std::string_view key) const;
+
+        // Capacity
+        std::size_t size() const;
+        bool empty() const;
+        void reserve(std::size_t capacity);
+
+        // Modifiers
+        void clear();
+        std::size_t erase(std::string_view key);
+        Bencode& append(Key key);
+        // Constructs the value in place, replacing the value of a present key
+        template <class... Args>
+        Bencode& emplace(Key key, Args&&... args);
+
+        // Comparison
+        bool operator==(const Dict& rhs) const;
+
+    private:
+        container_type::iterator lower_bound(std::string_view key);
+        container_type::const_iterator lower_bound(std::string_view key) const;
+        container_type data_;
+    };
 
     // Constructors
     Bencode();
+    // A std::string is copied into the default resource, a std::pmr::string
+    // is moved in
     Bencode(std::string value);
+    Bencode(std::pmr::string value);
     Bencode(const char *raw_string);
     Bencode(long value);
     Bencode(List value);
@@ -22,15 +132,85 @@ public:
     Bencode(std::initializer_list<Bencode> init);
 
     // Deserialize / Serialize
-    static Bencode Parse(std::istream& input);
+    static constexpr std::size_t kDefaultMaxDepth = 256;
+    static Bencode Parse(std::istream& input,
+                         std::size_t max_depth = kDefaultMaxDepth);
+    static Bencode Parse(std::string_view input,
+                         std::size_t max_depth = kDefaultMaxDepth);
+    static Bencode Parse(std::string_view input,
+                         std::pmr::memory_resource& resource,
+                         std::size_t max_depth = kDefaultMaxDepth);
+    static Bencode Parse(std::string_view input,
+                         std::pmr::memory_resource& resource,
+                         KeyTable& keys,
+                         std::size_t max_depth = kDefaultMaxDepth);
+    // Reads the file through a MappedFile, large files must not be
+    // truncated while they are parsed
+    static Bencode ParseFile(const std::filesystem::path& path,
+                             std::size_t max_depth = kDefaultMaxDepth);
+    // Spreads the elements of large containers, e.g. the file list of a
+    // torrent, over thread_count threads, all hardware threads when 0. The
+    // result and any error are the same as Parse. Nodes are taken from the
+    // default resource, which must be safe to use from several threads.
+    static Bencode ParseParallel(std::string_view input,
+                                 std::size_t thread_count = 0,
+                                 std::size_t max_depth = kDefaultMaxDepth);
+    // Receives the values of a document in order without building a tree.
+    // Strings and keys are views into the parsed input.
+    class EventHandler {
+    public:
+        virtual ~EventHandler() = default;
+        virtual void on_string(std::string_view) {}
+        virtual void on_integer(long) {}
+        virtual void begin_list() {}
+        virtual void end_list() {}
+        virtual void begin_dict() {}
+        virtual void key(std::string_view) {}
+        virtual void end_dict() {}
+    };
+    static void ParseEvents(std::string_view input, EventHandler& handler,
+                            std::size_t max_depth = kDefaultMaxDepth);
 private:
-    static Bencode ParseRecursive(std::istream& input);
-    static Bencode ParseString(std::istream& input);
-    static Bencode ParseInteger(std::istream& input);
-    static Bencode ParseList(std::istream& input);
-    static Bencode ParseDictionary(std::istream& input);
+    struct SplitNode;
+    struct Slice;
+    using SplitNodes = std::unordered_map<std::size_t, SplitNode>;
+    static void BuildSplit(std::string_view input, const SplitNodes& nodes,
+                           std::size_t begin, std::size_t depth,
+                           Bencode& target, KeyTable& keys,
+                           std::vector<Slice>& slices);
+    // Throwing forms of TryReadKey, TryReadString and TryReadInteger
+    static std::string_view ReadKey(std::string_view& input);
+    static std::string_view ReadString(std::string_view& input);
+    static long ReadInteger(std::string_view& input);
+    friend class BencodeView;
+    friend class BencodeIndex;
+    friend class BencodeLazyView;
+    friend class BencodeReader;
+    friend class BencodeWriter;
 public:
     std::string Dump() const;
+    std::size_t EncodedSize() const;
+    void DumpTo(std::string& output) const;
+    void DumpTo(std::ostream& output) const;
+    template <std::output_iterator<char> OutputIt>
+    OutputIt DumpTo(OutputIt output) const;
+private:
+    // Sinks provide append(const char*, std::size_t) and push_back(char)
+    template <class Sink>
+    void DumpToSink(Sink& sink) const;
+    template <class Sink>
+    static void DumpStringToSink(std::string_view string, Sink& sink);
+    template <class OutputIt>
+    struct IteratorSink {
+        void append(const char *data, std::size_t size) {
+            it = std::copy(data, data + size, it);
+        }
+        void push_back(char c) {
+            *it++ = c;
+        }
+        OutputIt it;
+    };
+public:
 
     // Inspection
     enum class ValueType {
@@ -46,51 +226,41 @@ public:
     std::string_view get_string() const;
     long get_int() const;
 
+    // Source
+    // Offsets of the node's encoding in the buffer it was parsed from, end
+    // exclusive. Nodes that were not parsed have none. Mutating a node drops
+    // its own range, but not the ranges of the containers above it.
+    struct SourceRange {
+        std::size_t begin;
+        std::size_t end;
+    };
+    std::optional<SourceRange> source_range() const;
+
     // Element access
     const Bencode& at(std::size_t idx) const;
-    const Bencode& at(const std::string& key) const;
+    const Bencode& at(std::string_view key) const;
     Bencode& operator[](std::size_t idx);
-    Bencode& operator[](const std::string& key);
+    Bencode& operator[](std::string_view key);
 
     // Iteration
-    class const_iterator {
-    public:
-        const_iterator(List::const_iterator it);
-        const_iterator(Dict::const_iterator it);
-        void operator++();
-        bool operator!=(const const_iterator& other) const;
-        Bencode operator*() const;
-    private:
-        enum class IteratorType {
-            List,
-            Dictionary
-        };
-        IteratorType type_;
-        std::variant<List::const_iterator, Dict::const_iterator> it_;
-    };
+    class const_iterator;
     const_iterator begin() const;
     const_iterator end() const;
 
+    // Borrows the dictionary, key-value pairs are yielded by reference
     class ConstIterationProxy {
-        class const_iterator {
-            Dict::const_iterator it_;
-        public:
-            const_iterator(Dict::const_iterator it);
-            void operator++();
-            bool operator!=(const const_iterator& other) const;
-            std::pair<std::string, Bencode> operator*() const;
-        };
     public:
+        using const_iterator = Dict::const_iterator;
         ConstIterationProxy(const Dict& data);
         const_iterator begin() const;
         const_iterator end() const;
     private:
-        const Dict data_;
+        const Dict *data_;
     };
     ConstIterationProxy items() const;
 
     // Lookup
-    bool contains(const std::string& key) const;
+    bool contains(std::string_view key) const;
 
     // Capacity
     std::size_t size() const;
@@ -98,9 +268,13 @@ public:
 
     // Modifiers
     void clear();
-    std::size_t erase(const std::string& key);
+    std::size_t erase(std::string_view key);
     void erase(std::size_t idx);
     void push_back(Bencode elem);
+    template <class... Args>
+    Bencode& emplace_back(Args&&... args);
+    template <class... Args>
+    Bencode& emplace(Key key, Args&&... args);
 
     // Comparison
     bool operator==(const Bencode& rhs) const;
@@ -121,13 +295,37 @@ public:
             kDictKeyNotString,
             kDictIncompletePair,
             kDictDuplicateKeys,
-            kDictBadOrder
+            kDictBadOrder,
+            kNestingTooDeep
         };
         ParseError(ExceptionID id);
         const char* what() const noexcept;
         const ExceptionID id_;
     };
 
+    // Reported instead of a ParseError by the non-throwing entry points,
+    // offset is the byte of the input at which the error was found
+    struct ParseFailure {
+        ParseError::ExceptionID id;
+        std::size_t offset;
+        friend bool operator==(const ParseFailure&,
+                               const ParseFailure&) = default;
+    };
+
+    // Non-throwing deserialize, for input that is often malformed. Failures
+    // carry the same IDs that Parse throws.
+    static std::expected<Bencode, ParseFailure> TryParse(
+        std::string_view input, std::size_t max_depth = kDefaultMaxDepth);
+    static std::expected<Bencode, ParseFailure> TryParse(
+        std::string_view input, std::pmr::memory_resource& resource,
+        std::size_t max_depth = kDefaultMaxDepth);
+    static std::expected<Bencode, ParseFailure> TryParse(
+        std::string_view input, std::pmr::memory_resource& resource,
+        KeyTable& keys, std::size_t max_depth = kDefaultMaxDepth);
+    // Checks input against every rule of Parse without building nodes
+    static std::expected<void, ParseFailure> Validate(
+        std::string_view input, std::size_t max_depth = kDefaultMaxDepth);
+
     class DumpError: public std::exception {
     public:
         enum class ExceptionID {
@@ -139,9 +337,138 @@ public:
     };
 
 private:
-    std::variant<std::monostate, std::string, long, List, Dict> data_;
+    // Source ranges are recorded as offsets from origin. Sets the error
+    // order every parser follows: an error is reported where it is found,
+    // except that a dictionary's kDictBadOrder, then kDictDuplicateKeys,
+    // waits for its postfix, so syntax errors inside it come first.
+    static std::expected<void, ParseFailure> ParseIterative(
+        std::string_view& input, Bencode& root_elem,
+        std::pmr::memory_resource& resource, KeyTable& keys,
+        std::size_t max_depth, const char *origin);
+    // Checks input like Parse and finds the containers ParseParallel splits
+    static std::expected<SplitNodes, ParseFailure> Skim(
+        std::string_view input, std::size_t grain, std::size_t max_depth);
+    using ReadError = ParseError::ExceptionID;
+    static std::expected<std::string_view, ReadError> TryReadKey(
+        std::string_view& input);
+    static std::expected<std::string_view, ReadError> TryReadString(
+        std::string_view& input);
+    static std::expected<long, ReadError> TryReadInteger(
+        std::string_view& input);
+
+    std::variant<std::monostate, std::pmr::string, long, List, Dict> data_;
+    SourceRange source_ {};
+};
+
+// Yields the elements of a list by reference. Iterating a dictionary yields
+// its keys as string nodes, which the iterator builds when it moves onto a
+// key, so a key reference is only valid until the iterator is advanced.
+// Two iterators at the same key hold different nodes, which makes this an
+// input iterator. items() iterates a dictionary with forward iterators.
+class Bencode::const_iterator {
+public:
+    using iterator_category = std::input_iterator_tag;
+    using value_type = Bencode;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const Bencode*;
+    using reference = const Bencode&;
+
+    const_iterator();
+    const_iterator(List::const_iterator it);
+    const_iterator(Dict::const_iterator it, Dict::const_iterator end);
+    const_iterator& operator++();
+    const_iterator operator++(int);
+    bool operator==(const const_iterator& other) const;
+    reference operator*() const;
+    pointer operator->() const;
+private:
+    void LoadKey();
+    std::variant<List::const_iterator, Dict::const_iterator> it_;
+    Dict::const_iterator dict_end_ {};
+    Bencode key_;
 };
 
+template <class... Args>
+Bencode& Bencode::Dict::emplace(Key key, Args&&... args) {
+    auto it = lower_bound(key);
+    if (it != data_.end() && it->first == key) {
+        it->second = Bencode(std::forward<Args>(args)...);
+        return it->second;
+    }
+    it = data_.emplace(it, std::piecewise_construct,
+                       std::forward_as_tuple(std::move(key)),
+                       std::forward_as_tuple(std::forward<Args>(args)...));
+    return it->second;
+}
+
+template <class... Args>
+Bencode& Bencode::emplace_back(Args&&... args) {
+    if (Type() == ValueType::kNull)
+        data_ = List {};
+    source_ = {};
+    return std::get<List>(data_).emplace_back(std::forward<Args>(args)...);
+}
+
+template <class... Args>
+Bencode& Bencode::emplace(Key key, Args&&... args) {
+    if (Type() == ValueType::kNull)
+        data_ = Dict {};
+    source_ = {};
+    return std::get<Dict>(data_).emplace(std::move(key),
+                                         std::forward<Args>(args)...);
+}
+
+template <std::output_iterator<char> OutputIt>
+OutputIt Bencode::DumpTo(OutputIt output) const {
+    IteratorSink<OutputIt> sink {output};
+    DumpToSink(sink);
+    return sink.it;
+}
+
+template <class Sink>
+void Bencode::DumpToSink(Sink& sink) const {
+    char number[24];
+    switch (Type()) {
+    case ValueType::kNull:
+        throw DumpError(DumpError::ExceptionID::kNull);
+    case ValueType::kString:
+        DumpStringToSink(std::get<std::pmr::string>(data_), sink);
+        break;
+    case ValueType::kInteger: {
+        char *end = std::to_chars(
+            number, number + sizeof(number), std::get<long>(data_)).ptr;
+        sink.push_back('i');
+        sink.append(number, end - number);
+        sink.push_back('e');
+        break;
+    }
+    case ValueType::kList:
+        sink.push_back('l');
+        for (const Bencode& elem : std::get<List>(data_))
+            elem.DumpToSink(sink);
+        sink.push_back('e');
+        break;
+    case ValueType::kDictionary:
+        sink.push_back('d');
+        for (const auto& [key, value] : std::get<Dict>(data_)) {
+            DumpStringToSink(key, sink);
+            value.DumpToSink(sink);
+        }
+        sink.push_back('e');
+        break;
+    }
+}
+
+template <class Sink>
+void Bencode::DumpStringToSink(std::string_view string, Sink& sink) {
+    char number[24];
+    char *end = std::to_chars(
+        number, number + sizeof(number), string.size()).ptr;
+    sink.append(number, end - number);
+    sink.push_back(':');
+    sink.append(string.data(), string.size());
+}
+
 // Deserialize / Serialize operators
 std::istream& operator>>(std::istream& i, Bencode& o);
 std::ostream& operator<<(std::ostream& o, const Bencode& i);
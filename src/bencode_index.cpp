@@ -0,0 +1,274 @@
+#include "bencode_index.h"
+
+#include <format>
+#include <stdexcept>
+
+BencodeIndex::BencodeIndex() {}
+
+
+BencodeIndex BencodeIndex::Build(std::string_view input,
+                                 std::size_t max_depth) {
+    BencodeIndex index {};
+    index.input_ = input;
+    if (input.empty())
+        return index;
+
+    // Errors are reported in the order of Bencode::ParseIterative
+    struct Frame {
+        std::size_t token;
+        std::string_view previous_key;
+        bool has_pairs;
+        bool bad_order;
+        bool duplicate_keys;
+    };
+    std::vector<Frame> stack {};
+    std::vector<Token>& tokens = index.tokens_;
+    // A first guess, values take two bytes at least and usually far more
+    tokens.reserve(input.size() / 16);
+    std::string_view rest = input;
+    auto offset = [&]() { return input.size() - rest.size(); };
+
+    while (true) {
+        if (rest.empty())
+            throw ParseError(ParseError::ExceptionID::kUnexpectedEOF);
+
+        std::size_t begin = offset();
+        switch (rest.front()) {
+        case '0':
+        case '1':
+        case '2':
+        case '3':
+        case '4':
+        case '5':
+        case '6':
+        case '7':
+        case '8':
+        case '9':
+        case '-':
+            Bencode::ReadString(rest);
+            tokens.push_back(Token {begin, offset(), tokens.size() + 1});
+            break;
+        case 'i':
+            Bencode::ReadInteger(rest);
+            tokens.push_back(Token {begin, offset(), tokens.size() + 1});
+            break;
+        case 'l':
+        case 'd':
+            if (stack.size() >= max_depth)
+                throw ParseError(ParseError::ExceptionID::kNestingTooDeep);
+            stack.push_back(Frame {tokens.size(), {}, false, false, false});
+            tokens.push_back(Token {begin, 0, 0});
+            rest.remove_prefix(1);  // Ignore l or d
+            break;
+        default:
+            throw ParseError(ParseError::ExceptionID::kBadPrefix);
+        }
+
+        // Close finished containers and index the key of the next pair
+        bool next_value = false;
+        while (!next_value && !stack.empty()) {
+            Frame& frame = stack.back();
+            if (rest.empty())
+                throw ParseError(ParseError::ExceptionID::kUnexpectedEOF);
+
+            if (rest.front() == 'e') {
+                if (frame.bad_order)
+                    throw ParseError(ParseError::ExceptionID::kDictBadOrder);
+                if (frame.duplicate_keys)
+                    throw ParseError(
+                        ParseError::ExceptionID::kDictDuplicateKeys);
+                rest.remove_prefix(1);  // Ignore e
+                tokens[frame.token].end = offset();
+                tokens[frame.token].next = tokens.size();
+                stack.pop_back();
+            }
+            else if (input[tokens[frame.token].begin] == 'l')
+                next_value = true;
+            else {
+                std::size_t key_begin = offset();
+                std::string_view key = Bencode::ReadKey(rest);
+                if (frame.has_pairs && key < frame.previous_key)
+                    frame.bad_order = true;
+                else if (frame.has_pairs && key == frame.previous_key)
+                    frame.duplicate_keys = true;
+                frame.previous_key = key;
+                frame.has_pairs = true;
+
+                if (!rest.empty() && rest.front() == 'e')
+                    throw ParseError(
+                        ParseError::ExceptionID::kDictIncompletePair);
+                tokens.push_back(Token {key_begin, offset(),
+                                        tokens.size() + 1});
+                next_value = true;
+            }
+        }
+
+        if (!next_value)
+            break;
+    }
+
+    if (!rest.empty())
+        throw ParseError(ParseError::ExceptionID::kTooMuchData);
+
+    return index;
+}
+
+
+std::size_t BencodeIndex::size() const {
+    return tokens_.size();
+}
+
+bool BencodeIndex::empty() const {
+    return tokens_.empty();
+}
+
+const BencodeIndex::Token& BencodeIndex::operator[](std::size_t idx) const {
+    return tokens_.at(idx);
+}
+
+BencodeIndex::ValueType BencodeIndex::Type(std::size_t idx) const {
+    switch (input_[tokens_.at(idx).begin]) {
+    case 'i':
+        return ValueType::kInteger;
+    case 'l':
+        return ValueType::kList;
+    case 'd':
+        return ValueType::kDictionary;
+    default:
+        return ValueType::kString;
+    }
+}
+
+std::size_t BencodeIndex::size(std::size_t idx) const {
+    ValueType type = Type(idx);
+    if (type != ValueType::kList && type != ValueType::kDictionary)
+        return 1;
+
+    std::size_t count = 0;
+    for (std::size_t child = idx + 1; child != tokens_[idx].next;
+            child = tokens_[child].next)
+        count++;
+    return type == ValueType::kList ? count : count / 2;
+}
+
+
+std::string_view BencodeIndex::get_string(std::size_t idx) const {
+    if (Type(idx) != ValueType::kString)
+        throw std::bad_variant_access();
+    std::string_view encoded = raw(idx);
+    return encoded.substr(encoded.find(':') + 1);
+}
+
+long BencodeIndex::get_int(std::size_t idx) const {
+    if (Type(idx) != ValueType::kInteger)
+        throw std::bad_variant_access();
+    std::string_view encoded = raw(idx);
+    return Bencode::ReadInteger(encoded);
+}
+
+std::string_view BencodeIndex::raw(std::size_t idx) const {
+    const Token& token = tokens_.at(idx);
+    return input_.substr(token.begin, token.end - token.begin);
+}
+
+
+std::size_t BencodeIndex::at(std::size_t idx, std::size_t position) const {
+    if (Type(idx) != ValueType::kList)
+        throw std::bad_variant_access();
+
+    std::size_t child = idx + 1;
+    for (std::size_t i = 0; i < position; i++) {
+        if (child == tokens_[idx].next)
+            break;
+        child = tokens_[child].next;
+    }
+    if (child == tokens_[idx].next)
+        throw std::out_of_range(std::format(
+            "Bad index. Size: {} Got: {}", size(idx), position));
+    return child;
+}
+
+std::size_t BencodeIndex::find(std::size_t idx, std::string_view key) const {
+    if (Type(idx) != ValueType::kDictionary)
+        throw std::bad_variant_access();
+
+    // Keys are sorted, so the scan stops at the first greater key. A key
+    // is a string and has no contents, its value is the next token.
+    std::size_t child = idx + 1;
+    while (child != tokens_[idx].next) {
+        std::string_view child_key = get_string(child);
+        if (child_key == key)
+            return child + 1;
+        else if (child_key > key)
+            break;
+        child = tokens_[child + 1].next;
+    }
+    return npos;
+}
+
+
+Bencode BencodeIndex::Materialize(std::size_t idx) const {
+    if (tokens_.empty() && idx == 0)
+        return Bencode {};
+    tokens_.at(idx);  // Throws std::out_of_range past the last token
+
+    // Containers are filled in place like in Bencode::ParseIterative, each
+    // frame points at a node that already sits in its parent. Tokens were
+    // checked by Build, so only the walk itself is left.
+    struct Frame {
+        Bencode *node;
+        std::size_t child;
+        std::size_t next;
+    };
+    std::vector<Frame> stack {};
+    Bencode::KeyTable keys {};
+    Bencode root {};
+    Bencode *target = &root;
+
+    while (true) {
+        switch (Type(idx)) {
+        case ValueType::kString:
+            target->data_.emplace<std::pmr::string>(get_string(idx));
+            break;
+        case ValueType::kInteger:
+            target->data_ = get_int(idx);
+            break;
+        case ValueType::kList:
+            target->data_.emplace<Bencode::List>().reserve(size(idx));
+            stack.push_back(Frame {target, idx + 1, tokens_[idx].next});
+            break;
+        case ValueType::kDictionary:
+            target->data_.emplace<Bencode::Dict>().reserve(size(idx));
+            stack.push_back(Frame {target, idx + 1, tokens_[idx].next});
+            break;
+        default:
+            throw std::logic_error("Unreachable state");
+        }
+
+        // Close finished containers and find the slot for the next value
+        target = nullptr;
+        while (target == nullptr && !stack.empty()) {
+            Frame& frame = stack.back();
+            if (frame.child == frame.next) {
+                stack.pop_back();
+            }
+            else if (frame.node->Type() == ValueType::kList) {
+                idx = frame.child;
+                frame.child = tokens_[idx].next;
+                target = &std::get<Bencode::List>(frame.node->data_)
+                    .emplace_back();
+            }
+            else {
+                // A key is a string, its value is the next token
+                std::string_view key = get_string(frame.child);
+                idx = frame.child + 1;
+                frame.child = tokens_[idx].next;
+                target = &std::get<Bencode::Dict>(frame.node->data_)
+                    .append(keys.intern(key));
+            }
+        }
+
+        if (target == nullptr)
+            return root;
+    }
+}
@@ -0,0 +1,61 @@
+#ifndef _BENCODE_INDEX_H
+#define _BENCODE_INDEX_H
+
+#include <cstddef>
+#include <string_view>
+#include <vector>
+
+#include "bencode.h"
+
+// Flat index of the values in a bencoded buffer, built by one validating
+// pass that allocates no nodes. Tokens are kept in document order and each
+// one records the index of the value after it, so a second pass can step
+// over whole subtrees and build only what it needs. Tokens refer to the
+// indexed buffer, which must outlive the index.
+class BencodeIndex {
+public:
+    using ValueType = Bencode::ValueType;
+    using ParseError = Bencode::ParseError;
+    static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+    // The type of a token follows from the first byte of its encoding
+    struct Token {
+        // Byte range of the encoded value, prefix and postfix included
+        std::size_t begin;
+        std::size_t end;
+        // Index of the first token after this value and its contents
+        std::size_t next;
+    };
+
+    // Constructors
+    BencodeIndex();
+    static BencodeIndex Build(
+        std::string_view input,
+        std::size_t max_depth = Bencode::kDefaultMaxDepth);
+
+    // Inspection
+    std::size_t size() const;
+    bool empty() const;
+    const Token& operator[](std::size_t idx) const;
+    ValueType Type(std::size_t idx) const;
+    // Elements of a list or pairs of a dictionary, like Bencode::size()
+    std::size_t size(std::size_t idx) const;
+
+    // Value access
+    std::string_view get_string(std::size_t idx) const;
+    long get_int(std::size_t idx) const;
+    std::string_view raw(std::size_t idx) const;
+
+    // Navigation, returns token indices
+    std::size_t at(std::size_t idx, std::size_t position) const;
+    std::size_t find(std::size_t idx, std::string_view key) const;
+
+    // Builds the value of a token and everything inside it
+    Bencode Materialize(std::size_t idx = 0) const;
+
+private:
+    std::string_view input_;
+    std::vector<Token> tokens_;
+};
+
+#endif // _BENCODE_INDEX_H
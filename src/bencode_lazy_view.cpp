@@ -0,0 +1,374 @@
+#include "bencode_lazy_view.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <format>
+#include <mutex>
+#include <stdexcept>
+
+BencodeLazyView::BencodeLazyView() : max_depth_(0), decoded_(false) {}
+
+BencodeLazyView::BencodeLazyView(const BencodeLazyView& other)
+    : encoded_(other.encoded_), max_depth_(other.max_depth_),
+      decoded_(false) {
+    if (other.decoded_.load(std::memory_order_acquire)) {
+        list_ = other.list_;
+        dict_ = other.dict_;
+        decoded_.store(true, std::memory_order_relaxed);
+    }
+}
+
+BencodeLazyView::BencodeLazyView(BencodeLazyView&& other) noexcept
+    : encoded_(other.encoded_), max_depth_(other.max_depth_),
+      decoded_(other.decoded_.load(std::memory_order_relaxed)),
+      list_(std::move(other.list_)), dict_(std::move(other.dict_)) {}
+
+BencodeLazyView& BencodeLazyView::operator=(const BencodeLazyView& other) {
+    if (this != &other)
+        *this = BencodeLazyView(other);
+    return *this;
+}
+
+BencodeLazyView& BencodeLazyView::operator=(
+        BencodeLazyView&& other) noexcept {
+    encoded_ = other.encoded_;
+    max_depth_ = other.max_depth_;
+    decoded_.store(other.decoded_.load(std::memory_order_relaxed),
+                   std::memory_order_relaxed);
+    list_ = std::move(other.list_);
+    dict_ = std::move(other.dict_);
+    return *this;
+}
+
+static BencodeLazyView::Dict::const_iterator LowerBound(
+        const BencodeLazyView::Dict& dict, std::string_view key) {
+    return std::lower_bound(dict.begin(), dict.end(), key,
+        [](const BencodeLazyView::Dict::value_type& elem,
+           std::string_view key) {
+            return elem.first < key;
+        });
+}
+
+
+BencodeLazyView BencodeLazyView::Parse(std::string_view input,
+                                       std::size_t max_depth) {
+    BencodeLazyView root_elem {};
+    if (input.empty())
+        return root_elem;
+
+    // Decoding the root finds its end in the same pass over the top level
+    root_elem.encoded_ = input;
+    root_elem.max_depth_ = max_depth;
+    switch (root_elem.Type()) {
+    case ValueType::kList:
+    case ValueType::kDictionary:
+        if (max_depth == 0)
+            throw ParseError(ParseError::ExceptionID::kNestingTooDeep);
+        root_elem.encoded_ = input.substr(0, root_elem.Decode());
+        break;
+    default: {
+        std::string_view rest = input;
+        Skip(rest, max_depth);
+        root_elem.encoded_ = input.substr(0, input.size() - rest.size());
+    }
+    }
+
+    if (root_elem.encoded_.size() != input.size())
+        throw ParseError(ParseError::ExceptionID::kTooMuchData);
+
+    return root_elem;
+}
+
+namespace {
+
+// Kind of each container that Skip has open, one bit per level set for a
+// dictionary. Only documents nested deeper than 64 levels use the heap.
+class ContainerStack {
+public:
+    std::size_t depth() const {
+        return depth_;
+    }
+    bool empty() const {
+        return depth_ == 0;
+    }
+    bool top_is_dict() const {
+        return (bits_ >> ((depth_ - 1) % 64)) & 1;
+    }
+    void push(bool dict) {
+        if (depth_ > 0 && depth_ % 64 == 0) {
+            spilled_.push_back(bits_);
+            bits_ = 0;
+        }
+        bits_ |= static_cast<std::uint64_t>(dict) << (depth_ % 64);
+        depth_++;
+    }
+    void pop() {
+        depth_--;
+        bits_ &= ~(std::uint64_t {1} << (depth_ % 64));
+        if (depth_ > 0 && depth_ % 64 == 0) {
+            bits_ = spilled_.back();
+            spilled_.pop_back();
+        }
+    }
+
+private:
+    std::size_t depth_ = 0;
+    std::uint64_t bits_ = 0;
+    std::vector<std::uint64_t> spilled_ {};
+};
+
+}
+
+void BencodeLazyView::Skip(std::string_view& input, std::size_t max_depth) {
+    ContainerStack stack {};
+    bool expecting_key = false;
+    do {
+        if (input.empty())
+            throw ParseError(ParseError::ExceptionID::kUnexpectedEOF);
+
+        if (expecting_key && input.front() != 'e') {
+            Bencode::ReadKey(input);
+            if (!input.empty() && input.front() == 'e')
+                throw ParseError(ParseError::ExceptionID::kDictIncompletePair);
+            expecting_key = false;
+            continue;
+        }
+
+        switch (input.front()) {
+        case '0':
+        case '1':
+        case '2':
+        case '3':
+        case '4':
+        case '5':
+        case '6':
+        case '7':
+        case '8':
+        case '9':
+        case '-':
+            Bencode::ReadString(input);
+            break;
+        case 'i':
+            Bencode::ReadInteger(input);
+            break;
+        case 'l':
+        case 'd':
+            if (stack.depth() >= max_depth)
+                throw ParseError(ParseError::ExceptionID::kNestingTooDeep);
+            stack.push(input.front() == 'd');
+            input.remove_prefix(1);  // Ignore l or d
+            break;
+        case 'e':
+            if (stack.empty())
+                throw ParseError(ParseError::ExceptionID::kBadPrefix);
+            input.remove_prefix(1);  // Ignore e
+            stack.pop();
+            break;
+        default:
+            throw ParseError(ParseError::ExceptionID::kBadPrefix);
+        }
+        // A finished value in a dictionary is followed by a key, as is
+        // the prefix of a dictionary
+        expecting_key = !stack.empty() && stack.top_is_dict();
+    } while (!stack.empty());
+}
+
+// Guards the first decode of the nodes that hash onto it
+static std::mutex& DecodeMutex(const void *node) {
+    static std::array<std::mutex, 64> mutexes {};
+    std::uintptr_t address = reinterpret_cast<std::uintptr_t>(node);
+    return mutexes[address / sizeof(BencodeLazyView) % mutexes.size()];
+}
+
+std::size_t BencodeLazyView::Decode() const {
+    if (decoded_.load(std::memory_order_acquire))
+        return encoded_.size();
+
+    std::lock_guard lock(DecodeMutex(this));
+    if (decoded_.load(std::memory_order_relaxed))
+        return encoded_.size();
+    std::size_t length = encoded_.size();
+    if (Type() == ValueType::kList)
+        length = DecodeList();
+    else if (Type() == ValueType::kDictionary)
+        length = DecodeDictionary();
+    decoded_.store(true, std::memory_order_release);
+    return length;
+}
+
+std::size_t BencodeLazyView::DecodeList() const {
+    std::string_view rest = encoded_;
+    rest.remove_prefix(1);  // Ignore l
+
+    List list {};
+    while (true) {
+        if (rest.empty())
+            throw ParseError(ParseError::ExceptionID::kUnexpectedEOF);
+        if (rest.front() == 'e')
+            break;
+
+        const char *begin = rest.data();
+        Skip(rest, max_depth_ - 1);
+        BencodeLazyView elem {};
+        elem.encoded_ = std::string_view(begin, rest.data());
+        elem.max_depth_ = max_depth_ - 1;
+        list.push_back(std::move(elem));
+    }
+
+    rest.remove_prefix(1);  // Ignore e
+    list_ = std::move(list);
+    return rest.data() - encoded_.data();
+}
+
+std::size_t BencodeLazyView::DecodeDictionary() const {
+    std::string_view rest = encoded_;
+    rest.remove_prefix(1);  // Ignore d
+
+    // Errors are reported in the order of Bencode::ParseIterative
+    Dict dict {};
+    bool bad_order = false;
+    bool duplicate_keys = false;
+    while (true) {
+        if (rest.empty())
+            throw ParseError(ParseError::ExceptionID::kUnexpectedEOF);
+        if (rest.front() == 'e')
+            break;
+
+        std::string_view key = Bencode::ReadKey(rest);
+        if (!dict.empty() && key < dict.back().first)
+            bad_order = true;
+        else if (!dict.empty() && key == dict.back().first)
+            duplicate_keys = true;
+
+        if (!rest.empty() && rest.front() == 'e')
+            throw ParseError(ParseError::ExceptionID::kDictIncompletePair);
+        const char *begin = rest.data();
+        Skip(rest, max_depth_ - 1);
+        BencodeLazyView value {};
+        value.encoded_ = std::string_view(begin, rest.data());
+        value.max_depth_ = max_depth_ - 1;
+        dict.emplace_back(key, std::move(value));
+    }
+
+    if (bad_order)
+        throw ParseError(ParseError::ExceptionID::kDictBadOrder);
+    if (duplicate_keys)
+        throw ParseError(ParseError::ExceptionID::kDictDuplicateKeys);
+
+    rest.remove_prefix(1);  // Ignore e
+    dict_ = std::move(dict);
+    return rest.data() - encoded_.data();
+}
+
+
+BencodeLazyView::ValueType BencodeLazyView::Type() const {
+    if (encoded_.empty())
+        return ValueType::kNull;
+
+    switch (encoded_.front()) {
+    case 'i':
+        return ValueType::kInteger;
+    case 'l':
+        return ValueType::kList;
+    case 'd':
+        return ValueType::kDictionary;
+    default:
+        return ValueType::kString;
+    }
+}
+
+
+std::string_view BencodeLazyView::get_string() const {
+    if (Type() != ValueType::kString)
+        throw std::bad_variant_access();
+    std::string_view rest = encoded_;
+    return Bencode::ReadString(rest);
+}
+
+long BencodeLazyView::get_int() const {
+    if (Type() != ValueType::kInteger)
+        throw std::bad_variant_access();
+    std::string_view rest = encoded_;
+    return Bencode::ReadInteger(rest);
+}
+
+std::string_view BencodeLazyView::raw() const {
+    return encoded_;
+}
+
+Bencode BencodeLazyView::Materialize() const {
+    return Bencode::Parse(encoded_, max_depth_);
+}
+
+
+const BencodeLazyView& BencodeLazyView::at(std::size_t idx) const {
+    if (Type() != ValueType::kList)
+        throw std::bad_variant_access();
+    Decode();
+    return list_.at(idx);
+}
+
+const BencodeLazyView& BencodeLazyView::at(std::string_view key) const {
+    if (Type() != ValueType::kDictionary)
+        throw std::bad_variant_access();
+    Decode();
+    auto it = LowerBound(dict_, key);
+    if (it == dict_.end() || it->first != key)
+        throw std::out_of_range(std::format("Bad key: {}", key));
+    return it->second;
+}
+
+
+BencodeLazyView::List::const_iterator BencodeLazyView::begin() const {
+    if (Type() != ValueType::kList)
+        throw std::bad_variant_access();
+    Decode();
+    return list_.cbegin();
+}
+
+BencodeLazyView::List::const_iterator BencodeLazyView::end() const {
+    if (Type() != ValueType::kList)
+        throw std::bad_variant_access();
+    Decode();
+    return list_.cend();
+}
+
+const BencodeLazyView::Dict& BencodeLazyView::items() const {
+    if (Type() != ValueType::kDictionary)
+        throw std::bad_variant_access();
+    Decode();
+    return dict_;
+}
+
+
+bool BencodeLazyView::contains(std::string_view key) const {
+    if (Type() != ValueType::kDictionary)
+        return false;
+    Decode();
+    auto it = LowerBound(dict_, key);
+    return it != dict_.end() && it->first == key;
+}
+
+
+std::size_t BencodeLazyView::size() const {
+    switch (Type()) {
+    case ValueType::kNull:
+        return 0;
+    case ValueType::kString:
+    case ValueType::kInteger:
+        return 1;
+    case ValueType::kList:
+        Decode();
+        return list_.size();
+    case ValueType::kDictionary:
+        Decode();
+        return dict_.size();
+    default:
+        throw std::logic_error("Unreachable state");
+    }
+}
+
+bool BencodeLazyView::empty() const {
+    return size() == 0;
+}
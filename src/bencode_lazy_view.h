@@ -0,0 +1,85 @@
+#ifndef _BENCODE_LAZY_VIEW_H
+#define _BENCODE_LAZY_VIEW_H
+
+#include <atomic>
+#include <cstddef>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "bencode.h"
+
+// Read-only Bencode node that decodes on demand. A container finds the
+// extent of its children the first time one of them is accessed, and
+// steps over their contents without building anything: strings by their
+// length prefix, containers by a scan that only allocates past 64 levels.
+// Subtrees that are never accessed are checked against every rule of
+// Bencode::Parse except dictionary key order, so e.g. an unsorted
+// dictionary nested inside one is only reported once it is accessed.
+//
+// Decoded children are cached in the node. The first decode of a node
+// holds a lock, so const access is safe from several threads at once.
+// The buffer must outlive the view.
+class BencodeLazyView {
+public:
+    using ValueType = Bencode::ValueType;
+    using ParseError = Bencode::ParseError;
+    using List = std::vector<BencodeLazyView>;
+    using Dict = std::vector<std::pair<std::string_view, BencodeLazyView>>;
+
+    // Constructors
+    BencodeLazyView();
+    // A node that another thread is still decoding is copied undecoded
+    BencodeLazyView(const BencodeLazyView& other);
+    BencodeLazyView(BencodeLazyView&& other) noexcept;
+    BencodeLazyView& operator=(const BencodeLazyView& other);
+    BencodeLazyView& operator=(BencodeLazyView&& other) noexcept;
+
+    // Deserialize
+    static BencodeLazyView Parse(
+        std::string_view input,
+        std::size_t max_depth = Bencode::kDefaultMaxDepth);
+private:
+    // Opens at most max_depth containers
+    static void Skip(std::string_view& input, std::size_t max_depth);
+    // Return the length of the encoding, which only the root lacks
+    std::size_t Decode() const;
+    std::size_t DecodeList() const;
+    std::size_t DecodeDictionary() const;
+public:
+    // Inspection
+    ValueType Type() const;
+
+    // Value access
+    std::string_view get_string() const;
+    long get_int() const;
+    // Encoding of the value, as it appears in the parsed buffer
+    std::string_view raw() const;
+    Bencode Materialize() const;
+
+    // Element access
+    const BencodeLazyView& at(std::size_t idx) const;
+    const BencodeLazyView& at(std::string_view key) const;
+
+    // Iteration
+    List::const_iterator begin() const;
+    List::const_iterator end() const;
+    const Dict& items() const;
+
+    // Lookup
+    bool contains(std::string_view key) const;
+
+    // Capacity
+    std::size_t size() const;
+    bool empty() const;
+
+private:
+    std::string_view encoded_;
+    // Containers this node and the values inside it may open
+    std::size_t max_depth_;
+    mutable std::atomic<bool> decoded_;
+    mutable List list_;
+    mutable Dict dict_;
+};
+
+#endif // _BENCODE_LAZY_VIEW_H
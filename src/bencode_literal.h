@@ -0,0 +1,261 @@
+#ifndef _BENCODE_LITERAL_H
+#define _BENCODE_LITERAL_H
+
+#include <array>
+#include <charconv>
+#include <concepts>
+#include <cstddef>
+#include <initializer_list>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "bencode.h"
+
+// Placeholder for a value that is supplied each time a literal is dumped
+struct BencodeSlot {};
+
+// What a slot takes: a string, a long or a whole Bencode value
+template <class T>
+concept BencodeSlotValue = std::convertible_to<const T&, std::string_view>
+                        || std::same_as<T, long> || std::same_as<T, Bencode>;
+
+// Bencode value that can be built in a constant expression. It is only
+// meant to be returned from the function passed to BencodeEncode, which
+// encodes it at compile time. The constructors follow Bencode: an
+// initializer list with a string at every even position is a dictionary
+// and a repeated key keeps its last value, anything else is a list.
+class BencodeConst {
+public:
+    using List = std::vector<BencodeConst>;
+
+    // Constructors
+    constexpr BencodeConst(const char *raw_string)
+        : type_(Type::kString), string_(raw_string) {}
+    constexpr BencodeConst(std::string_view value)
+        : type_(Type::kString), string_(value) {}
+    constexpr BencodeConst(long value)
+        : type_(Type::kInteger), integer_(value) {}
+    constexpr BencodeConst(BencodeSlot) : type_(Type::kSlot) {}
+    constexpr BencodeConst(List value)
+        : type_(Type::kList), children_(std::move(value)) {}
+    constexpr BencodeConst(std::initializer_list<BencodeConst> init);
+
+    // Size of the encoding, slots excluded
+    constexpr std::size_t EncodedSize() const;
+    constexpr std::size_t SlotCount() const;
+    // Writes the encoding at output and the offset of each slot from
+    // begin at slots, advancing both
+    constexpr void Encode(char *&output, const char *begin,
+                          std::size_t *&slots) const;
+
+private:
+    enum class Type {
+        kString,
+        kInteger,
+        kList,
+        kDictionary,
+        kSlot
+    };
+
+    static constexpr std::size_t DigitCount(unsigned long value);
+    static constexpr void EncodeNumber(char *&output, unsigned long value);
+    static constexpr void EncodeString(char *&output, std::string_view value);
+
+    Type type_;
+    std::string_view string_ {};
+    long integer_ {};
+    // Dictionaries alternate keys and values, sorted by key
+    List children_ {};
+};
+
+constexpr BencodeConst::BencodeConst(std::initializer_list<BencodeConst> init)
+        : type_(Type::kDictionary) {
+    bool construct_dict = init.size() % 2 == 0;
+    for (auto it = init.begin(); construct_dict && it != init.end(); it += 2)
+        construct_dict = it->type_ == Type::kString;
+
+    if (!construct_dict) {
+        type_ = Type::kList;
+        children_ = List(init.begin(), init.end());
+        return;
+    }
+
+    for (auto it = init.begin(); it != init.end(); it += 2) {
+        auto pos = children_.begin();
+        while (pos != children_.end() && pos->string_ < it->string_)
+            pos += 2;
+        if (pos != children_.end() && pos->string_ == it->string_)
+            *(pos + 1) = *(it + 1);
+        else
+            children_.insert(children_.insert(pos, *(it + 1)), *it);
+    }
+}
+
+constexpr std::size_t BencodeConst::EncodedSize() const {
+    std::size_t size = 0;
+    switch (type_) {
+    case Type::kString:
+        return DigitCount(string_.size()) + 1 + string_.size();
+    case Type::kInteger:
+        if (integer_ < 0)
+            size++;
+        return size + 2 + DigitCount(
+            integer_ < 0 ? 0ul - integer_ : integer_);
+    case Type::kList:
+    case Type::kDictionary:
+        size = 2;
+        for (const BencodeConst& child : children_)
+            size += child.EncodedSize();
+        return size;
+    case Type::kSlot:
+        break;
+    }
+    return size;
+}
+
+constexpr std::size_t BencodeConst::SlotCount() const {
+    if (type_ == Type::kSlot)
+        return 1;
+    std::size_t count = 0;
+    for (const BencodeConst& child : children_)
+        count += child.SlotCount();
+    return count;
+}
+
+constexpr void BencodeConst::Encode(char *&output, const char *begin,
+                                    std::size_t *&slots) const {
+    switch (type_) {
+    case Type::kString:
+        EncodeString(output, string_);
+        break;
+    case Type::kInteger:
+        *output++ = 'i';
+        if (integer_ < 0)
+            *output++ = '-';
+        EncodeNumber(output, integer_ < 0 ? 0ul - integer_ : integer_);
+        *output++ = 'e';
+        break;
+    case Type::kList:
+    case Type::kDictionary:
+        *output++ = type_ == Type::kList ? 'l' : 'd';
+        for (const BencodeConst& child : children_)
+            child.Encode(output, begin, slots);
+        *output++ = 'e';
+        break;
+    case Type::kSlot:
+        *slots++ = output - begin;
+        break;
+    }
+}
+
+constexpr std::size_t BencodeConst::DigitCount(unsigned long value) {
+    std::size_t count = 1;
+    for (; value >= 10; value /= 10)
+        count++;
+    return count;
+}
+
+constexpr void BencodeConst::EncodeNumber(char *&output,
+                                          unsigned long value) {
+    std::size_t count = DigitCount(value);
+    for (std::size_t i = count; i > 0; i--, value /= 10)
+        output[i - 1] = static_cast<char>('0' + value % 10);
+    output += count;
+}
+
+constexpr void BencodeConst::EncodeString(char *&output,
+                                          std::string_view value) {
+    EncodeNumber(output, value.size());
+    *output++ = ':';
+    for (char c : value)
+        *output++ = c;
+}
+
+
+// Encoding of a BencodeConst produced at compile time. Slots are filled in
+// the order they appear in the encoding, which for a dictionary is key
+// order.
+template <std::size_t N, std::size_t SlotCount>
+struct BencodeLiteral {
+    std::array<char, N> bytes;
+    std::array<std::size_t, SlotCount> slots;
+
+    constexpr std::string_view view() const requires (SlotCount == 0) {
+        return std::string_view(bytes.data(), N);
+    }
+
+    template <class... Args>
+        requires (sizeof...(Args) == SlotCount
+                  && (BencodeSlotValue<Args> && ...))
+    void DumpTo(std::string& output, const Args&... args) const {
+        std::size_t done = 0;
+        std::size_t slot = 0;
+        auto splice = [&](const auto& arg) {
+            output.append(bytes.data() + done, slots[slot] - done);
+            done = slots[slot++];
+            DumpSlot(output, arg);
+        };
+        (splice(args), ...);
+        output.append(bytes.data() + done, N - done);
+    }
+
+    template <class... Args>
+        requires (sizeof...(Args) == SlotCount
+                  && (BencodeSlotValue<Args> && ...))
+    std::string Dump(const Args&... args) const {
+        std::string output;
+        output.reserve(N + 32 * SlotCount);
+        DumpTo(output, args...);
+        return output;
+    }
+
+private:
+    template <class Arg>
+    static void DumpSlot(std::string& output, const Arg& arg) {
+        char number[24];
+        if constexpr (std::convertible_to<const Arg&, std::string_view>) {
+            std::string_view value = arg;
+            char *end = std::to_chars(
+                number, number + sizeof(number), value.size()).ptr;
+            output.append(number, end - number);
+            output.push_back(':');
+            output.append(value);
+        }
+        else if constexpr (std::same_as<Arg, long>) {
+            char *end = std::to_chars(
+                number, number + sizeof(number), arg).ptr;
+            output.push_back('i');
+            output.append(number, end - number);
+            output.push_back('e');
+        }
+        else {
+            arg.DumpTo(output);
+        }
+    }
+};
+
+// Encodes the BencodeConst returned by build at compile time. build must
+// be a lambda without captures:
+//
+//     constexpr auto kHandshake = BencodeEncode([] {
+//         return BencodeConst {"m", BencodeConst {"ut_metadata", 1l},
+//                              "v", "ftor"};
+//     });
+//     kHandshake.view();  // "d1:md11:ut_metadatai1ee1:v4:ftore"
+template <class Build>
+    requires std::default_initializable<Build>
+          && std::convertible_to<std::invoke_result_t<Build>, BencodeConst>
+consteval auto BencodeEncode(Build) {
+    constexpr std::size_t size = BencodeConst(Build {}()).EncodedSize();
+    constexpr std::size_t slot_count = BencodeConst(Build {}()).SlotCount();
+    BencodeLiteral<size, slot_count> literal {};
+    char *output = literal.bytes.data();
+    std::size_t *slots = literal.slots.data();
+    BencodeConst(Build {}()).Encode(output, literal.bytes.data(), slots);
+    return literal;
+}
+
+#endif // _BENCODE_LITERAL_H
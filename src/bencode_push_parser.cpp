@@ -0,0 +1,244 @@
+#include "bencode_push_parser.h"
+
+#include <algorithm>
+#include <limits>
+
+BencodePushParser::BencodePushParser(std::size_t max_depth)
+        : max_depth_(max_depth) {
+    Reset();
+}
+
+void BencodePushParser::Reset() {
+    state_ = State::kValue;
+    started_ = false;
+    stack_.clear();
+    string_length_ = 0;
+    string_.clear();
+    magnitude_ = 0;
+    negative_ = false;
+    keys_.clear();
+    root_ = Bencode();
+}
+
+
+BencodePushParser::Status BencodePushParser::Feed(std::string_view chunk) {
+    if (!chunk.empty())
+        started_ = true;
+
+    while (!chunk.empty()) {
+        char c = chunk.front();
+        switch (state_) {
+        case State::kValue:
+            if (stack_.empty())
+                StartValue(c);
+            else if (c == 'e') {
+                const Frame& frame = stack_.back();
+                if (frame.container.Type() == Bencode::ValueType::kDictionary
+                        && !frame.expecting_key)
+                    throw ParseError(
+                        ParseError::ExceptionID::kDictIncompletePair);
+                CloseContainer();
+            }
+            else if (stack_.back().expecting_key)
+                StartKey(c);
+            else
+                StartValue(c);
+            break;
+        case State::kStringLeading0:
+            if (c >= '0' && c <= '9')
+                throw ParseError(ParseError::ExceptionID::kLeading0);
+            else if (c != ':')
+                throw ParseError(ParseError::ExceptionID::kStringMissingColon);
+            CompleteString();
+            break;
+        case State::kStringLength:
+            if (c >= '0' && c <= '9') {
+                std::size_t digit = c - '0';
+                if (string_length_ > (std::numeric_limits<std::size_t>::max()
+                                      - digit) / 10)
+                    throw ParseError(ParseError::ExceptionID::kUnexpectedEOF);
+                string_length_ = string_length_ * 10 + digit;
+            }
+            else if (c != ':')
+                throw ParseError(ParseError::ExceptionID::kStringMissingColon);
+            else if (string_length_ == 0)
+                CompleteString();
+            else
+                state_ = State::kStringBody;
+            break;
+        case State::kStringBody: {
+            // Copy as much of the string as this chunk holds in one go
+            std::size_t count = std::min(string_length_, chunk.size());
+            string_.append(chunk.substr(0, count));
+            string_length_ -= count;
+            chunk.remove_prefix(count);
+            if (string_length_ == 0)
+                CompleteString();
+            continue;
+        }
+        case State::kIntegerStart:
+            if (c == 'e')
+                throw ParseError(ParseError::ExceptionID::kIntegerEmpty);
+            else if (c == '-') {
+                negative_ = true;
+                state_ = State::kIntegerSign;
+                break;
+            }
+            [[fallthrough]];
+        case State::kIntegerSign:
+        case State::kIntegerDigits:
+            if (c >= '0' && c <= '9') {
+                // Same rule as Bencode::TryReadInteger
+                if ((state_ == State::kIntegerSign && c == '0')
+                        || (state_ == State::kIntegerDigits && magnitude_ == 0))
+                    throw ParseError(ParseError::ExceptionID::kLeading0);
+                unsigned long limit = std::numeric_limits<long>::max();
+                if (negative_)
+                    limit += 1;
+                unsigned long digit = c - '0';
+                if (magnitude_ > (limit - digit) / 10)
+                    throw ParseError(
+                        ParseError::ExceptionID::kIntegerNonDecimal);
+                magnitude_ = magnitude_ * 10 + digit;
+                state_ = State::kIntegerDigits;
+            }
+            else if (state_ != State::kIntegerDigits)
+                throw ParseError(ParseError::ExceptionID::kIntegerNonDecimal);
+            else if (c != 'e')
+                throw ParseError(ParseError::ExceptionID::kMissingPostfix);
+            else {
+                long number = negative_ ? static_cast<long>(0 - magnitude_)
+                                        : static_cast<long>(magnitude_);
+                CompleteValue(Bencode(number));
+            }
+            break;
+        case State::kComplete:
+            throw ParseError(ParseError::ExceptionID::kTooMuchData);
+        }
+        chunk.remove_prefix(1);
+    }
+
+    return state_ == State::kComplete ? Status::kComplete : Status::kNeedMore;
+}
+
+Bencode BencodePushParser::Finish() {
+    switch (state_) {
+    case State::kComplete: {
+        Bencode root_elem = std::move(root_);
+        Reset();
+        return root_elem;
+    }
+    case State::kStringLeading0:
+    case State::kStringLength:
+        throw ParseError(ParseError::ExceptionID::kStringMissingColon);
+    default:
+        if (started_)
+            throw ParseError(ParseError::ExceptionID::kUnexpectedEOF);
+        return Bencode();
+    }
+}
+
+
+void BencodePushParser::StartValue(char prefix) {
+    switch (prefix) {
+    case '-':
+        throw ParseError(ParseError::ExceptionID::kNegativeStringLength);
+    case '0':
+        string_length_ = 0;
+        state_ = State::kStringLeading0;
+        break;
+    case '1':
+    case '2':
+    case '3':
+    case '4':
+    case '5':
+    case '6':
+    case '7':
+    case '8':
+    case '9':
+        string_length_ = prefix - '0';
+        state_ = State::kStringLength;
+        break;
+    case 'i':
+        magnitude_ = 0;
+        negative_ = false;
+        state_ = State::kIntegerStart;
+        break;
+    case 'l':
+    case 'd':
+        if (stack_.size() >= max_depth_)
+            throw ParseError(ParseError::ExceptionID::kNestingTooDeep);
+        if (prefix == 'l')
+            stack_.push_back(
+                Frame {Bencode::List {}, false, {}, {}, false, false});
+        else
+            stack_.push_back(
+                Frame {Bencode::Dict {}, true, {}, {}, false, false});
+        break;
+    default:
+        throw ParseError(ParseError::ExceptionID::kBadPrefix);
+    }
+}
+
+void BencodePushParser::StartKey(char prefix) {
+    switch (prefix) {
+    case 'i':
+    case 'l':
+    case 'd':
+        throw ParseError(ParseError::ExceptionID::kDictKeyNotString);
+    default:
+        StartValue(prefix);
+    }
+}
+
+void BencodePushParser::CompleteString() {
+    if (!stack_.empty() && stack_.back().expecting_key) {
+        // Errors are reported in the order of Bencode::ParseIterative
+        Frame& frame = stack_.back();
+        if (!frame.previous_key.empty() || !frame.container.empty()) {
+            if (string_ < frame.previous_key)
+                frame.bad_order = true;
+            else if (string_ == frame.previous_key)
+                frame.duplicate_keys = true;
+        }
+        frame.key = std::move(string_);
+        frame.expecting_key = false;
+        string_.clear();
+        state_ = State::kValue;
+        return;
+    }
+
+    Bencode value(std::move(string_));
+    string_.clear();
+    CompleteValue(std::move(value));
+}
+
+void BencodePushParser::CompleteValue(Bencode value) {
+    state_ = State::kValue;
+    if (stack_.empty()) {
+        root_ = std::move(value);
+        state_ = State::kComplete;
+        return;
+    }
+
+    Frame& frame = stack_.back();
+    if (frame.container.Type() == Bencode::ValueType::kList)
+        frame.container.push_back(std::move(value));
+    else {
+        // Assigning keeps the capacity of previous_key for the next key
+        frame.previous_key = frame.key;
+        frame.container.emplace(keys_.intern(frame.key), std::move(value));
+        frame.key.clear();
+        frame.expecting_key = true;
+    }
+}
+
+void BencodePushParser::CloseContainer() {
+    Frame frame = std::move(stack_.back());
+    stack_.pop_back();
+    if (frame.bad_order)
+        throw ParseError(ParseError::ExceptionID::kDictBadOrder);
+    if (frame.duplicate_keys)
+        throw ParseError(ParseError::ExceptionID::kDictDuplicateKeys);
+    CompleteValue(std::move(frame.container));
+}
@@ -0,0 +1,69 @@
+#ifndef _BENCODE_PUSH_PARSER_H
+#define _BENCODE_PUSH_PARSER_H
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "bencode.h"
+
+// Incremental Bencode parser for input that arrives in chunks, e.g. from a
+// socket. Partial tokens and open containers are kept between calls to
+// Feed(), so every byte is looked at exactly once. After a ParseError the
+// parser must be Reset() before it is fed again. Containers nested deeper
+// than max_depth fail with kNestingTooDeep, as in Bencode::Parse.
+class BencodePushParser {
+public:
+    using ParseError = Bencode::ParseError;
+    enum class Status {
+        kNeedMore,
+        kComplete
+    };
+
+    explicit BencodePushParser(
+        std::size_t max_depth = Bencode::kDefaultMaxDepth);
+
+    Status Feed(std::string_view chunk);
+    Bencode Finish();
+    void Reset();
+
+private:
+    enum class State {
+        kValue,
+        kStringLeading0,
+        kStringLength,
+        kStringBody,
+        kIntegerStart,
+        kIntegerSign,
+        kIntegerDigits,
+        kComplete
+    };
+    struct Frame {
+        Bencode container;
+        bool expecting_key;
+        std::pmr::string key;
+        std::pmr::string previous_key;
+        bool bad_order;
+        bool duplicate_keys;
+    };
+
+    void StartValue(char prefix);
+    void StartKey(char prefix);
+    void CompleteString();
+    void CompleteValue(Bencode value);
+    void CloseContainer();
+
+    std::size_t max_depth_;
+    State state_;
+    bool started_;
+    std::vector<Frame> stack_;
+    std::size_t string_length_;
+    std::pmr::string string_;
+    unsigned long magnitude_;
+    bool negative_;
+    Bencode::KeyTable keys_;
+    Bencode root_;
+};
+
+#endif // _BENCODE_PUSH_PARSER_H
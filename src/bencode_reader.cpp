@@ -0,0 +1,228 @@
+#include "bencode_reader.h"
+
+#include <type_traits>
+#include <variant>
+
+// Value of a try_ form, its failure is raised as the ParseError it holds
+template <class T>
+static T OrThrow(BencodeReader::Result<T> result) {
+    if (!result)
+        throw Bencode::ParseError(result.error());
+    if constexpr (!std::is_void_v<T>)
+        return std::move(*result);
+}
+
+BencodeReader::BencodeReader(std::string_view input, std::size_t max_depth)
+    : input_(input), origin_(input.data()), max_depth_(max_depth) {}
+
+
+BencodeReader::ValueType BencodeReader::peek() const {
+    return OrThrow(try_peek());
+}
+
+BencodeReader::Result<BencodeReader::ValueType>
+BencodeReader::try_peek() const {
+    if (input_.empty())
+        return ValueType::kNull;
+
+    switch (input_.front()) {
+    case '0':
+    case '1':
+    case '2':
+    case '3':
+    case '4':
+    case '5':
+    case '6':
+    case '7':
+    case '8':
+    case '9':
+    case '-':
+        return ValueType::kString;
+    case 'i':
+        return ValueType::kInteger;
+    case 'l':
+        return ValueType::kList;
+    case 'd':
+        return ValueType::kDictionary;
+    default:
+        return std::unexpected(ParseError::ExceptionID::kBadPrefix);
+    }
+}
+
+std::size_t BencodeReader::offset() const {
+    return input_.data() - origin_;
+}
+
+std::string_view BencodeReader::consumed(std::size_t begin) const {
+    return std::string_view(origin_ + begin, input_.data());
+}
+
+
+std::string_view BencodeReader::read_string() {
+    if (peek() != ValueType::kString)
+        throw std::bad_variant_access();
+    return OrThrow(try_read_string());
+}
+
+BencodeReader::Result<std::string_view> BencodeReader::try_read_string() {
+    return Bencode::TryReadString(input_);
+}
+
+long BencodeReader::read_int() {
+    if (peek() != ValueType::kInteger)
+        throw std::bad_variant_access();
+    return OrThrow(try_read_int());
+}
+
+BencodeReader::Result<long> BencodeReader::try_read_int() {
+    return Bencode::TryReadInteger(input_);
+}
+
+void BencodeReader::skip() {
+    OrThrow(try_skip());
+}
+
+BencodeReader::Result<void> BencodeReader::try_skip() {
+    std::size_t depth = stack_.size();
+    std::string_view key;
+    while (true) {
+        Result<ValueType> type = try_peek();
+        if (!type)
+            return std::unexpected(type.error());
+        Result<void> read {};
+        switch (*type) {
+        case ValueType::kNull:
+            return std::unexpected(ParseError::ExceptionID::kUnexpectedEOF);
+        case ValueType::kString:
+            if (auto string = try_read_string(); !string)
+                return std::unexpected(string.error());
+            break;
+        case ValueType::kInteger:
+            if (auto integer = try_read_int(); !integer)
+                return std::unexpected(integer.error());
+            break;
+        case ValueType::kList:
+            read = try_begin_list();
+            break;
+        case ValueType::kDictionary:
+            read = try_begin_dict();
+            break;
+        }
+        if (!read)
+            return read;
+
+        // Close finished containers and find the next value
+        while (true) {
+            if (stack_.size() == depth)
+                return {};
+            Result<bool> more = stack_.back().dict ? try_next_key(key)
+                                                   : try_next_element();
+            if (!more)
+                return std::unexpected(more.error());
+            if (*more)
+                break;
+        }
+    }
+}
+
+
+void BencodeReader::begin_list() {
+    if (peek() != ValueType::kList)
+        throw std::bad_variant_access();
+    OrThrow(try_begin_list());
+}
+
+BencodeReader::Result<void> BencodeReader::try_begin_list() {
+    return BeginContainer(false);
+}
+
+void BencodeReader::begin_dict() {
+    if (peek() != ValueType::kDictionary)
+        throw std::bad_variant_access();
+    OrThrow(try_begin_dict());
+}
+
+BencodeReader::Result<void> BencodeReader::try_begin_dict() {
+    return BeginContainer(true);
+}
+
+bool BencodeReader::next_element() {
+    return OrThrow(try_next_element());
+}
+
+BencodeReader::Result<bool> BencodeReader::try_next_element() {
+    // Outside any container whatever is left trails the top-level value
+    if (stack_.empty())
+        return std::unexpected(ParseError::ExceptionID::kTooMuchData);
+    if (input_.empty())
+        return std::unexpected(ParseError::ExceptionID::kUnexpectedEOF);
+    if (input_.front() == 'e') {
+        if (Result<void> closed = CloseContainer(); !closed)
+            return std::unexpected(closed.error());
+        return false;
+    }
+    return true;
+}
+
+bool BencodeReader::next_key(std::string_view& key) {
+    return OrThrow(try_next_key(key));
+}
+
+BencodeReader::Result<bool> BencodeReader::try_next_key(
+        std::string_view& key) {
+    // Outside any container whatever is left trails the top-level value
+    if (stack_.empty())
+        return std::unexpected(ParseError::ExceptionID::kTooMuchData);
+    if (input_.empty())
+        return std::unexpected(ParseError::ExceptionID::kUnexpectedEOF);
+    if (input_.front() == 'e') {
+        if (Result<void> closed = CloseContainer(); !closed)
+            return std::unexpected(closed.error());
+        return false;
+    }
+
+    Frame& frame = stack_.back();
+    bool first_key = frame.previous_key.data() == nullptr;
+    auto read_key = Bencode::TryReadKey(input_);
+    if (!read_key)
+        return std::unexpected(read_key.error());
+    key = *read_key;
+    if (!first_key && key < frame.previous_key)
+        frame.bad_order = true;
+    else if (!first_key && key == frame.previous_key)
+        frame.duplicate_keys = true;
+    frame.previous_key = key;
+
+    if (!input_.empty() && input_.front() == 'e')
+        return std::unexpected(ParseError::ExceptionID::kDictIncompletePair);
+    return true;
+}
+
+BencodeReader::Result<void> BencodeReader::BeginContainer(bool dict) {
+    if (stack_.size() >= max_depth_)
+        return std::unexpected(ParseError::ExceptionID::kNestingTooDeep);
+    input_.remove_prefix(1);  // Ignore l or d
+    stack_.push_back(Frame {dict, {}, false, false});
+    return {};
+}
+
+BencodeReader::Result<void> BencodeReader::CloseContainer() {
+    const Frame& frame = stack_.back();
+    if (frame.bad_order)
+        return std::unexpected(ParseError::ExceptionID::kDictBadOrder);
+    if (frame.duplicate_keys)
+        return std::unexpected(ParseError::ExceptionID::kDictDuplicateKeys);
+    input_.remove_prefix(1);  // Ignore e
+    stack_.pop_back();
+    return {};
+}
+
+void BencodeReader::finish() const {
+    OrThrow(try_finish());
+}
+
+BencodeReader::Result<void> BencodeReader::try_finish() const {
+    if (!input_.empty())
+        return std::unexpected(ParseError::ExceptionID::kTooMuchData);
+    return {};
+}
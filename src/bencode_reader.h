@@ -0,0 +1,81 @@
+#ifndef _BENCODE_READER_H
+#define _BENCODE_READER_H
+
+#include <cstddef>
+#include <expected>
+#include <string_view>
+#include <vector>
+
+#include "bencode.h"
+
+// Cursor that reads the values of a bencoded buffer in document order
+// without building nodes. It raises the same ParseError IDs as
+// Bencode::Parse, dictionary ordering errors included. Strings point into
+// the buffer, which must outlive them.
+//
+// Each method has a try_ form that returns the ID of the failure instead
+// of raising it, offset() is then where it was found. The try_ forms
+// expect the value to be of the type peek() reported, the others raise
+// std::bad_variant_access otherwise.
+class BencodeReader {
+public:
+    using ValueType = Bencode::ValueType;
+    using ParseError = Bencode::ParseError;
+    template <class T>
+    using Result = std::expected<T, ParseError::ExceptionID>;
+
+    explicit BencodeReader(std::string_view input,
+                           std::size_t max_depth = Bencode::kDefaultMaxDepth);
+
+    // Inspection
+    // Type of the next value, kNull at the end of the input
+    ValueType peek() const;
+    Result<ValueType> try_peek() const;
+    // Offset of the next byte to read
+    std::size_t offset() const;
+    // Bytes read since offset begin
+    std::string_view consumed(std::size_t begin) const;
+
+    // Value access
+    std::string_view read_string();
+    Result<std::string_view> try_read_string();
+    long read_int();
+    Result<long> try_read_int();
+    // Reads the next value and everything inside it
+    void skip();
+    Result<void> try_skip();
+
+    // Containers
+    void begin_list();
+    Result<void> try_begin_list();
+    void begin_dict();
+    Result<void> try_begin_dict();
+    // False after reading the postfix of the current container. Outside
+    // any container they fail with kTooMuchData.
+    bool next_element();
+    Result<bool> try_next_element();
+    bool next_key(std::string_view& key);
+    Result<bool> try_next_key(std::string_view& key);
+
+    // Raises kTooMuchData unless the whole input was read
+    void finish() const;
+    Result<void> try_finish() const;
+
+private:
+    // Errors are reported in the order of Bencode::ParseIterative
+    struct Frame {
+        bool dict;
+        std::string_view previous_key;
+        bool bad_order;
+        bool duplicate_keys;
+    };
+    Result<void> BeginContainer(bool dict);
+    Result<void> CloseContainer();
+
+    std::string_view input_;
+    const char *origin_;
+    std::size_t max_depth_;
+    std::vector<Frame> stack_;
+};
+
+#endif // _BENCODE_READER_H
@@ -0,0 +1,309 @@
+#ifndef _BENCODE_SCHEMA_H
+#define _BENCODE_SCHEMA_H
+
+#include <array>
+#include <concepts>
+#include <cstddef>
+#include <expected>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "bencode.h"
+#include "bencode_reader.h"
+
+// Describes how a struct is decoded from a bencoded dictionary. A
+// specialization names the exception to raise and lists the fields:
+//
+//     template <>
+//     struct BencodeSchema<File> {
+//         using Error = FileError;
+//         static constexpr std::tuple fields {
+//             BencodeField<&File::length>("length", kMissing, kNotInt)
+//         };
+//         // Optional, receives the encoding of the dictionary
+//         static constexpr auto encoding = &File::encoding;
+//     };
+//
+// Members may be long, std::string, std::string_view, std::vector and
+// std::optional of those, or structs with a schema of their own. A field
+// is required unless its member is a std::optional.
+//
+// A member of type std::expected<V, ID> keeps the first error found in its
+// field, a missing key included, instead of reporting it for the whole
+// struct. The caller then checks the fields in whatever order it needs.
+template <class T>
+struct BencodeSchema;
+
+template <class T>
+concept BencodeDecodable = requires {
+    typename BencodeSchema<T>::Error;
+    BencodeSchema<T>::fields;
+};
+
+template <class M>
+struct BencodeMember;
+
+template <class C, class V>
+struct BencodeMember<V C::*> {
+    using Class = C;
+    using Value = V;
+};
+
+// Dictionary key decoded into Member. Wrong types raise wrong_type, and
+// element_wrong_type for the elements of a list.
+template <auto Member, class ID>
+struct BencodeFieldSpec {
+    using Value = typename BencodeMember<decltype(Member)>::Value;
+    static constexpr auto member = Member;
+    std::string_view key;
+    ID missing;
+    ID wrong_type;
+    ID element_wrong_type;
+};
+
+template <auto Member, class ID>
+constexpr BencodeFieldSpec<Member, ID> BencodeField(
+        std::string_view key, ID missing, ID wrong_type) {
+    return {key, missing, wrong_type, wrong_type};
+}
+
+template <auto Member, class ID>
+constexpr BencodeFieldSpec<Member, ID> BencodeField(
+        std::string_view key, ID missing, ID wrong_type,
+        ID element_wrong_type) {
+    return {key, missing, wrong_type, element_wrong_type};
+}
+
+template <class V>
+constexpr bool kBencodeIsOptional = false;
+template <class V>
+constexpr bool kBencodeIsOptional<std::optional<V>> = true;
+template <class V>
+constexpr bool kBencodeIsVector = false;
+template <class V>
+constexpr bool kBencodeIsVector<std::vector<V>> = true;
+template <class V>
+constexpr bool kBencodeIsExpected = false;
+template <class V, class E>
+constexpr bool kBencodeIsExpected<std::expected<V, E>> = true;
+
+// Decodes in a single pass over the buffer. The first syntax error stops
+// the decode. The first schema error is held until the whole buffer has
+// been checked, so a malformed document always reports a syntax error, as
+// it would if it were parsed into a tree.
+template <class Error>
+class BencodeSchemaDecoder {
+public:
+    using ID = typename Error::ExceptionID;
+    using Failure = std::variant<Bencode::ParseFailure, ID>;
+    using Status = BencodeReader::Result<void>;
+
+    explicit BencodeSchemaDecoder(std::string_view input)
+        : reader_(input), sink_(&error_) {}
+
+    // Raises Bencode::ParseError or Error
+    template <BencodeDecodable T>
+    T Decode(ID not_dict) {
+        std::expected<T, Failure> output = TryDecode<T>(not_dict);
+        if (!output) {
+            if (auto *failure = std::get_if<Bencode::ParseFailure>(
+                    &output.error()))
+                throw Bencode::ParseError(failure->id);
+            throw Error(std::get<ID>(output.error()));
+        }
+        return std::move(*output);
+    }
+
+    // Returns the failure Decode would raise, nothing is thrown
+    template <BencodeDecodable T>
+    std::expected<T, Failure> TryDecode(ID not_dict) {
+        T output {};
+        Status status = DecodeStruct(output, not_dict);
+        if (status)
+            status = reader_.try_finish();
+        if (!status)
+            return std::unexpected(Bencode::ParseFailure {
+                status.error(), reader_.offset()
+            });
+        if (error_)
+            return std::unexpected(*error_);
+        return output;
+    }
+
+private:
+    // Only the first error is kept, the value is still checked for syntax
+    Status Mismatch(ID id, Bencode::ValueType type) {
+        if (!*sink_)
+            *sink_ = id;
+        if (type == Bencode::ValueType::kNull)
+            return {};
+        return reader_.try_skip();
+    }
+
+    template <class V>
+    Status DecodeValue(V& output, ID wrong_type, ID element_wrong_type) {
+        auto type = reader_.try_peek();
+        if (!type)
+            return std::unexpected(type.error());
+        if constexpr (std::same_as<V, long>) {
+            if (*type != Bencode::ValueType::kInteger)
+                return Mismatch(wrong_type, *type);
+            return Store(output, reader_.try_read_int());
+        }
+        else if constexpr (std::same_as<V, std::string_view>) {
+            if (*type != Bencode::ValueType::kString)
+                return Mismatch(wrong_type, *type);
+            return Store(output, reader_.try_read_string());
+        }
+        else if constexpr (std::same_as<V, std::string>) {
+            if (*type != Bencode::ValueType::kString)
+                return Mismatch(wrong_type, *type);
+            return Store(output, reader_.try_read_string());
+        }
+        else if constexpr (kBencodeIsOptional<V>) {
+            return DecodeValue(output.emplace(), wrong_type,
+                               element_wrong_type);
+        }
+        else if constexpr (kBencodeIsExpected<V>) {
+            // Errors inside the value go to the member until it is decoded
+            std::optional<ID> error {};
+            std::optional<ID> *outer_sink = std::exchange(sink_, &error);
+            Status status = DecodeValue(output.emplace(), wrong_type,
+                                        element_wrong_type);
+            sink_ = outer_sink;
+            if (error)
+                output = std::unexpected(*error);
+            return status;
+        }
+        else if constexpr (kBencodeIsVector<V>) {
+            if (*type != Bencode::ValueType::kList)
+                return Mismatch(wrong_type, *type);
+            if (Status status = reader_.try_begin_list(); !status)
+                return status;
+            while (true) {
+                auto more = reader_.try_next_element();
+                if (!more)
+                    return std::unexpected(more.error());
+                if (!*more)
+                    return {};
+                Status status = DecodeValue(output.emplace_back(),
+                    element_wrong_type, element_wrong_type);
+                if (!status)
+                    return status;
+            }
+        }
+        else {
+            return DecodeStruct(output, wrong_type);
+        }
+    }
+
+    template <class V, class R>
+    static Status Store(V& output, BencodeReader::Result<R> value) {
+        if (!value)
+            return std::unexpected(value.error());
+        output = V(*value);
+        return {};
+    }
+
+    template <BencodeDecodable T>
+    Status DecodeStruct(T& output, ID not_dict) {
+        using Schema = BencodeSchema<T>;
+        static_assert(std::same_as<typename Schema::Error, Error>,
+                      "nested schemas must raise the same error");
+        constexpr std::size_t field_count =
+            std::tuple_size_v<decltype(Schema::fields)>;
+
+        auto type = reader_.try_peek();
+        if (!type)
+            return std::unexpected(type.error());
+        if (*type != Bencode::ValueType::kDictionary)
+            return Mismatch(not_dict, *type);
+        std::size_t begin = reader_.offset();
+        if (Status status = reader_.try_begin_dict(); !status)
+            return status;
+
+        std::array<bool, field_count> seen {};
+        std::string_view key;
+        while (true) {
+            auto more = reader_.try_next_key(key);
+            if (!more)
+                return std::unexpected(more.error());
+            if (!*more)
+                break;
+            bool matched = false;
+            Status status {};
+            [&]<std::size_t... I>(std::index_sequence<I...>) {
+                ((matched = matched
+                    || DecodeField<I>(output, key, seen[I], status)), ...);
+            }(std::make_index_sequence<field_count> {});
+            if (!matched)
+                status = reader_.try_skip();
+            if (!status)
+                return status;
+        }
+
+        [&]<std::size_t... I>(std::index_sequence<I...>) {
+            (CheckPresent<I>(output, seen[I]), ...);
+        }(std::make_index_sequence<field_count> {});
+
+        if constexpr (requires { Schema::encoding; })
+            output.*Schema::encoding = reader_.consumed(begin);
+        return {};
+    }
+
+    template <std::size_t I, class T>
+    bool DecodeField(T& output, std::string_view key, bool& seen,
+                     Status& status) {
+        const auto& field = std::get<I>(BencodeSchema<T>::fields);
+        if (field.key != key)
+            return false;
+        seen = true;
+        status = DecodeValue(output.*field.member, field.wrong_type,
+                             field.element_wrong_type);
+        return true;
+    }
+
+    template <std::size_t I, class T>
+    void CheckPresent(T& output, bool seen) {
+        const auto& field = std::get<I>(BencodeSchema<T>::fields);
+        using Value = typename std::remove_cvref_t<decltype(field)>::Value;
+        if (seen || kBencodeIsOptional<Value>)
+            return;
+        if constexpr (kBencodeIsExpected<Value>)
+            output.*field.member = std::unexpected(field.missing);
+        else if (!*sink_)
+            *sink_ = field.missing;
+    }
+
+    BencodeReader reader_;
+    std::optional<ID> error_;
+    // Where the next error is kept, error_ or the innermost expected member
+    std::optional<ID> *sink_;
+};
+
+// Decodes input into T without building a Bencode tree. A root that is
+// not a dictionary raises not_dict.
+template <BencodeDecodable T>
+T BencodeDecode(std::string_view input,
+                typename BencodeSchema<T>::Error::ExceptionID not_dict) {
+    return BencodeSchemaDecoder<typename BencodeSchema<T>::Error>(input)
+        .template Decode<T>(not_dict);
+}
+
+// Non-throwing BencodeDecode, the failure holds the ID of the
+// Bencode::ParseError or schema error it would raise
+template <BencodeDecodable T>
+std::expected<T, typename BencodeSchemaDecoder<
+    typename BencodeSchema<T>::Error>::Failure>
+BencodeTryDecode(std::string_view input,
+                 typename BencodeSchema<T>::Error::ExceptionID not_dict) {
+    return BencodeSchemaDecoder<typename BencodeSchema<T>::Error>(input)
+        .template TryDecode<T>(not_dict);
+}
+
+#endif // _BENCODE_SCHEMA_H
@@ -0,0 +1,216 @@
+#include "bencode_view.h"
+
+#include <vector>
+
+BencodeView::BencodeView() {}
+
+
+BencodeView BencodeView::Parse(std::string_view input,
+                               std::size_t max_depth) {
+    BencodeView root_elem {};
+    if (input.empty())
+        return root_elem;
+
+    ParseIterative(input, root_elem, max_depth);
+
+    if (!input.empty())
+        throw ParseError(ParseError::ExceptionID::kTooMuchData);
+
+    return root_elem;
+}
+
+BencodeView BencodeView::Parse(std::span<const std::byte> input,
+                               std::size_t max_depth) {
+    return Parse(std::string_view(
+        reinterpret_cast<const char*>(input.data()), input.size()), max_depth);
+}
+
+void BencodeView::ParseIterative(std::string_view& input,
+                                 BencodeView& root_elem,
+                                 std::size_t max_depth) {
+    // Follows Bencode::ParseIterative, errors included: containers are
+    // filled in place and only the innermost one grows, so the frames'
+    // pointers stay valid
+    struct Frame {
+        BencodeView *node;
+        std::string_view previous_key;
+        bool bad_order;
+        bool duplicate_keys;
+    };
+    std::vector<Frame> stack {};
+    BencodeView *target = &root_elem;
+
+    while (true) {
+        if (input.empty())
+            throw ParseError(ParseError::ExceptionID::kUnexpectedEOF);
+
+        switch (input.front()) {
+        case '0':
+        case '1':
+        case '2':
+        case '3':
+        case '4':
+        case '5':
+        case '6':
+        case '7':
+        case '8':
+        case '9':
+        case '-':
+            target->data_ = Bencode::ReadString(input);
+            break;
+        case 'i':
+            target->data_ = Bencode::ReadInteger(input);
+            break;
+        case 'l':
+        case 'd':
+            if (stack.size() >= max_depth)
+                throw ParseError(ParseError::ExceptionID::kNestingTooDeep);
+            if (input.front() == 'l')
+                target->data_.emplace<List>();
+            else
+                target->data_.emplace<Dict>();
+            input.remove_prefix(1);  // Ignore l or d
+            stack.push_back(Frame {target, {}, false, false});
+            break;
+        default:
+            throw ParseError(ParseError::ExceptionID::kBadPrefix);
+        }
+
+        // Close finished containers and find the slot for the next value
+        target = nullptr;
+        while (target == nullptr && !stack.empty()) {
+            Frame& frame = stack.back();
+            if (input.empty())
+                throw ParseError(ParseError::ExceptionID::kUnexpectedEOF);
+
+            if (input.front() == 'e') {
+                if (frame.bad_order)
+                    throw ParseError(ParseError::ExceptionID::kDictBadOrder);
+                if (frame.duplicate_keys)
+                    throw ParseError(
+                        ParseError::ExceptionID::kDictDuplicateKeys);
+                input.remove_prefix(1);  // Ignore e
+                stack.pop_back();
+            }
+            else if (frame.node->Type() == ValueType::kList) {
+                List& list = std::get<List>(frame.node->data_);
+                target = &list.emplace_back();
+            }
+            else {
+                Dict& dict = std::get<Dict>(frame.node->data_);
+                std::string_view key = Bencode::ReadKey(input);
+                if (!dict.empty() && key < frame.previous_key)
+                    frame.bad_order = true;
+                else if (!dict.empty() && key == frame.previous_key)
+                    frame.duplicate_keys = true;
+                frame.previous_key = key;
+
+                if (!input.empty() && input.front() == 'e')
+                    throw ParseError(
+                        ParseError::ExceptionID::kDictIncompletePair);
+                // A repeated key reuses its finished slot, the frame fails
+                // on its postfix before the view is returned
+                target = &(dict[key] = BencodeView {});
+            }
+        }
+
+        if (target == nullptr)
+            return;
+    }
+}
+
+
+BencodeView::ValueType BencodeView::Type() const {
+    switch (data_.index()) {
+    case 0:
+        return ValueType::kNull;
+    case 1:
+        return ValueType::kString;
+    case 2:
+        return ValueType::kInteger;
+    case 3:
+        return ValueType::kList;
+    case 4:
+        return ValueType::kDictionary;
+    default:
+        throw std::logic_error("Unreachable state");
+    }
+}
+
+
+std::string_view BencodeView::get_string() const {
+    return std::get<std::string_view>(data_);
+}
+
+long BencodeView::get_int() const {
+    return std::get<long>(data_);
+}
+
+
+const BencodeView& BencodeView::at(std::size_t idx) const {
+    return std::get<List>(data_).at(idx);
+}
+
+const BencodeView& BencodeView::at(std::string_view key) const {
+    return std::get<Dict>(data_).at(key);
+}
+
+
+BencodeView::List::const_iterator BencodeView::begin() const {
+    return std::get<List>(data_).cbegin();
+}
+
+BencodeView::List::const_iterator BencodeView::end() const {
+    return std::get<List>(data_).cend();
+}
+
+const BencodeView::Dict& BencodeView::items() const {
+    return std::get<Dict>(data_);
+}
+
+
+bool BencodeView::contains(std::string_view key) const {
+    if (Type() != ValueType::kDictionary)
+        return false;
+    return std::get<Dict>(data_).contains(key);
+}
+
+
+std::size_t BencodeView::size() const {
+    switch (Type()) {
+    case ValueType::kNull:
+        return 0;
+    case ValueType::kString:
+        return 1;
+    case ValueType::kInteger:
+        return 1;
+    case ValueType::kList:
+        return std::get<List>(data_).size();
+    case ValueType::kDictionary:
+        return std::get<Dict>(data_).size();
+    default:
+        throw std::logic_error("Unreachable state");
+    }
+}
+
+bool BencodeView::empty() const {
+    switch (Type()) {
+    case ValueType::kNull:
+        return true;
+    case ValueType::kString:
+        return false;
+    case ValueType::kInteger:
+        return false;
+    case ValueType::kList:
+        return std::get<List>(data_).empty();
+    case ValueType::kDictionary:
+        return std::get<Dict>(data_).empty();
+    default:
+        throw std::logic_error("Unreachable state");
+    }
+}
+
+
+bool BencodeView::operator==(const BencodeView& rhs) const {
+    return data_ == rhs.data_;
+}
@@ -0,0 +1,67 @@
+#ifndef _BENCODE_VIEW_H
+#define _BENCODE_VIEW_H
+
+#include <cstddef>
+#include <map>
+#include <span>
+#include <string_view>
+#include <variant>
+#include <vector>
+
+#include "bencode.h"
+
+// Read-only counterpart of Bencode. String nodes point into the parsed
+// buffer instead of owning a copy, so the buffer must outlive the view.
+class BencodeView {
+public:
+    using List = std::vector<BencodeView>;
+    using Dict = std::map<std::string_view, BencodeView>;
+    using ValueType = Bencode::ValueType;
+    using ParseError = Bencode::ParseError;
+
+    // Constructors
+    BencodeView();
+
+    // Deserialize
+    static BencodeView Parse(
+        std::string_view input,
+        std::size_t max_depth = Bencode::kDefaultMaxDepth);
+    static BencodeView Parse(
+        std::span<const std::byte> input,
+        std::size_t max_depth = Bencode::kDefaultMaxDepth);
+private:
+    static void ParseIterative(std::string_view& input,
+                               BencodeView& root_elem,
+                               std::size_t max_depth);
+public:
+    // Inspection
+    ValueType Type() const;
+
+    // Value access
+    std::string_view get_string() const;
+    long get_int() const;
+
+    // Element access
+    const BencodeView& at(std::size_t idx) const;
+    const BencodeView& at(std::string_view key) const;
+
+    // Iteration
+    List::const_iterator begin() const;
+    List::const_iterator end() const;
+    const Dict& items() const;
+
+    // Lookup
+    bool contains(std::string_view key) const;
+
+    // Capacity
+    std::size_t size() const;
+    bool empty() const;
+
+    // Comparison
+    bool operator==(const BencodeView& rhs) const;
+
+private:
+    std::variant<std::monostate, std::string_view, long, List, Dict> data_;
+};
+
+#endif // _BENCODE_VIEW_H
@@ -0,0 +1,229 @@
+#include "bencode_writer.h"
+
+#include <cerrno>
+#include <charconv>
+#include <system_error>
+
+#include <unistd.h>
+
+BencodeWriter::BencodeWriter(std::string& output) : output_(&output) {}
+
+BencodeWriter::BencodeWriter(std::ostream& output)
+    : output_(&buffer_), stream_(&output) {}
+
+BencodeWriter::BencodeWriter(int fd) : output_(&buffer_), fd_(fd) {}
+
+
+void BencodeWriter::value(std::string_view string) {
+    BeginValue();
+    AppendNumber(string.size());
+    output_->push_back(':');
+    Append(string);
+}
+
+void BencodeWriter::value(const char *string) {
+    value(std::string_view(string));
+}
+
+void BencodeWriter::value(const std::string& string) {
+    value(std::string_view(string));
+}
+
+void BencodeWriter::value(long integer) {
+    BeginValue();
+    char number[24];
+    char *end = std::to_chars(number, number + sizeof(number), integer).ptr;
+    output_->push_back('i');
+    output_->append(number, end - number);
+    output_->push_back('e');
+    FlushIfFull();
+}
+
+// Passes the encoding through the writer's buffer, so a large tree is
+// written out as it is encoded instead of being buffered whole
+struct BencodeWriter::NodeSink {
+    void append(const char *data, std::size_t size) {
+        writer.Append(std::string_view(data, size));
+    }
+    void push_back(char c) {
+        writer.output_->push_back(c);
+        writer.FlushIfFull();
+    }
+    BencodeWriter& writer;
+};
+
+void BencodeWriter::value(const Bencode& node) {
+    // Sizing the tree raises on any null in it, before the write starts
+    node.EncodedSize();
+    BeginValue();
+    NodeSink sink {*this};
+    node.DumpToSink(sink);
+}
+
+void BencodeWriter::begin_string(std::size_t size) {
+    BeginValue();
+    AppendNumber(size);
+    output_->push_back(':');
+    string_remaining_ = size;
+}
+
+void BencodeWriter::append_string(std::string_view part) {
+    if (part.size() > string_remaining_)
+        throw WriteError(WriteError::ExceptionID::kStringLength);
+    string_remaining_ -= part.size();
+    Append(part);
+}
+
+
+void BencodeWriter::begin_list() {
+    BeginValue();
+    output_->push_back('l');
+    stack_.push_back(Frame {false, false, false, {}});
+}
+
+void BencodeWriter::end_list() {
+    EndContainer(false);
+}
+
+void BencodeWriter::begin_dict() {
+    BeginValue();
+    output_->push_back('d');
+    stack_.push_back(Frame {true, false, false, {}});
+}
+
+void BencodeWriter::key(std::string_view key) {
+    CheckString();
+    if (stack_.empty() || !stack_.back().dict)
+        throw WriteError(WriteError::ExceptionID::kKeyOutsideDict);
+    Frame& frame = stack_.back();
+    if (frame.pending_value)
+        throw WriteError(WriteError::ExceptionID::kDictIncompletePair);
+    if (frame.has_key && key == frame.previous_key)
+        throw WriteError(WriteError::ExceptionID::kDictDuplicateKeys);
+    if (frame.has_key && key < frame.previous_key)
+        throw WriteError(WriteError::ExceptionID::kDictBadOrder);
+    frame.previous_key.assign(key);
+    frame.has_key = true;
+    frame.pending_value = true;
+
+    AppendNumber(key.size());
+    output_->push_back(':');
+    Append(key);
+}
+
+void BencodeWriter::end_dict() {
+    EndContainer(true);
+}
+
+
+void BencodeWriter::finish() {
+    CheckString();
+    if (!stack_.empty() || !root_written_)
+        throw WriteError(WriteError::ExceptionID::kIncomplete);
+    Flush();
+}
+
+
+void BencodeWriter::BeginValue() {
+    CheckString();
+    if (stack_.empty()) {
+        if (root_written_)
+            throw WriteError(WriteError::ExceptionID::kTooMuchData);
+        root_written_ = true;
+        return;
+    }
+
+    Frame& frame = stack_.back();
+    if (frame.dict && !frame.pending_value)
+        throw WriteError(WriteError::ExceptionID::kValueWithoutKey);
+    frame.pending_value = false;
+}
+
+void BencodeWriter::EndContainer(bool dict) {
+    CheckString();
+    if (stack_.empty() || stack_.back().dict != dict)
+        throw WriteError(WriteError::ExceptionID::kMismatchedEnd);
+    if (stack_.back().pending_value)
+        throw WriteError(WriteError::ExceptionID::kDictIncompletePair);
+    stack_.pop_back();
+    output_->push_back('e');
+    FlushIfFull();
+}
+
+void BencodeWriter::CheckString() const {
+    if (string_remaining_ != 0)
+        throw WriteError(WriteError::ExceptionID::kStringLength);
+}
+
+void BencodeWriter::Append(std::string_view data) {
+    // Large strings skip the buffer instead of being copied into it
+    if (output_ == &buffer_ && data.size() >= kFlushSize) {
+        Flush();
+        WriteOut(data);
+        return;
+    }
+    output_->append(data);
+    FlushIfFull();
+}
+
+void BencodeWriter::AppendNumber(unsigned long value) {
+    char number[24];
+    char *end = std::to_chars(number, number + sizeof(number), value).ptr;
+    output_->append(number, end - number);
+}
+
+void BencodeWriter::FlushIfFull() {
+    if (output_ == &buffer_ && buffer_.size() >= kFlushSize)
+        Flush();
+}
+
+void BencodeWriter::Flush() {
+    if (output_ != &buffer_ || buffer_.empty())
+        return;
+    WriteOut(buffer_);
+    buffer_.clear();
+}
+
+void BencodeWriter::WriteOut(std::string_view data) {
+    if (stream_ != nullptr) {
+        stream_->write(data.data(), data.size());
+        return;
+    }
+    while (!data.empty()) {
+        ssize_t written = write(fd_, data.data(), data.size());
+        if (written < 0 && errno == EINTR)
+            continue;
+        if (written < 0)
+            throw std::system_error(errno, std::generic_category(),
+                                    "BencodeWriter");
+        data.remove_prefix(written);
+    }
+}
+
+
+BencodeWriter::WriteError::WriteError(ExceptionID id) : id_(id) {}
+
+const char* BencodeWriter::WriteError::what() const noexcept {
+    switch (id_) {
+    case ExceptionID::kTooMuchData:
+        return "write error - value after root entry";
+    case ExceptionID::kValueWithoutKey:
+        return "write error - dictionary value without key";
+    case ExceptionID::kKeyOutsideDict:
+        return "write error - key outside of dictionary";
+    case ExceptionID::kDictIncompletePair:
+        return "write error - key-value pair missing value";
+    case ExceptionID::kDictDuplicateKeys:
+        return "write error - duplicate keys";
+    case ExceptionID::kDictBadOrder:
+        return "write error - key-value pairs must be ordered";
+    case ExceptionID::kMismatchedEnd:
+        return "write error - end does not match an open container";
+    case ExceptionID::kStringLength:
+        return "write error - string parts don't match its size";
+    case ExceptionID::kIncomplete:
+        return "write error - document is incomplete";
+    default:
+        return "BencodeWriter::WriteError::what, Not yet implemented";
+    }
+}
@@ -0,0 +1,122 @@
+#ifndef _BENCODE_WRITER_H
+#define _BENCODE_WRITER_H
+
+#include <concepts>
+#include <cstddef>
+#include <exception>
+#include <format>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include "bencode.h"
+
+// Writes a bencoded document value by value, without building nodes. The
+// structure is checked as it is written: dictionary keys must come in
+// strictly increasing order and every key needs a value. Stream and file
+// descriptor output is buffered until finish(). A writer destroyed without
+// a successful finish() discards its buffer, only the parts flushed once
+// the buffer filled up reach the output.
+class BencodeWriter {
+public:
+    // Appends to output
+    explicit BencodeWriter(std::string& output);
+    explicit BencodeWriter(std::ostream& output);
+    // Writes to an open file descriptor, which the writer doesn't close
+    explicit BencodeWriter(int fd);
+    BencodeWriter(const BencodeWriter&) = delete;
+    BencodeWriter& operator=(const BencodeWriter&) = delete;
+
+    // Values
+    void value(std::string_view string);
+    void value(const char *string);
+    void value(const std::string& string);
+    void value(long integer);
+    // Other integer types, e.g. a literal 0, raise std::out_of_range unless
+    // the value fits in a long
+    template <std::integral Integer>
+    void value(Integer integer);
+    // Encodes a whole tree, e.g. a part of the document kept as a Bencode,
+    // flushing as the buffer fills up. Raises Bencode::DumpError before
+    // writing anything if it holds a null.
+    void value(const Bencode& node);
+    // Writes a string of known size in parts, e.g. piece hashes as they
+    // are computed. The parts must add up to size before the next write.
+    void begin_string(std::size_t size);
+    void append_string(std::string_view part);
+
+    // Containers
+    void begin_list();
+    void end_list();
+    void begin_dict();
+    void key(std::string_view key);
+    void end_dict();
+
+    // Raises kIncomplete unless one whole value was written, then flushes
+    void finish();
+
+    class WriteError: public std::exception {
+    public:
+        enum class ExceptionID {
+            kTooMuchData,
+            kValueWithoutKey,
+            kKeyOutsideDict,
+            kDictIncompletePair,
+            kDictDuplicateKeys,
+            kDictBadOrder,
+            kMismatchedEnd,
+            kStringLength,
+            kIncomplete
+        };
+        WriteError(ExceptionID id);
+        const char* what() const noexcept;
+        const ExceptionID id_;
+    };
+
+private:
+    // Sink for Bencode::DumpToSink
+    struct NodeSink;
+    struct Frame {
+        bool dict;
+        bool has_key;
+        bool pending_value;
+        std::string previous_key;
+    };
+    // Checks that a value may start here and records it as written
+    void BeginValue();
+    void EndContainer(bool dict);
+    void CheckString() const;
+    void Append(std::string_view data);
+    void AppendNumber(unsigned long value);
+    void FlushIfFull();
+    void Flush();
+    // Writes data to the stream or file descriptor
+    void WriteOut(std::string_view data);
+
+    // Buffered output is written out once it reaches this size
+    static constexpr std::size_t kFlushSize = 64 * 1024;
+
+    std::string *output_;
+    std::string buffer_ {};
+    std::ostream *stream_ = nullptr;
+    int fd_ = -1;
+    std::vector<Frame> stack_ {};
+    bool root_written_ = false;
+    std::size_t string_remaining_ = 0;
+};
+
+template <std::integral Integer>
+void BencodeWriter::value(Integer integer) {
+    long number = static_cast<long>(integer);
+    bool wrapped = static_cast<Integer>(number) != integer;
+    if constexpr (std::is_unsigned_v<Integer>)
+        wrapped = wrapped || number < 0;
+    if (wrapped)
+        throw std::out_of_range(std::format("Bad integer. Got: {}", integer));
+    value(number);
+}
+
+#endif // _BENCODE_WRITER_H
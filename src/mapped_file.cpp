@@ -0,0 +1,115 @@
+#include "mapped_file.h"
+
+#include <cerrno>
+#include <system_error>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+MappedFile::MappedFile(const std::filesystem::path& path)
+        : address_(nullptr), size_(0) {
+    // O_NONBLOCK keeps open from waiting for a writer on a FIFO, it has no
+    // effect on regular files
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC | O_NONBLOCK);
+    if (fd < 0)
+        throw std::system_error(errno, std::generic_category(), path.string());
+    auto fail = [&](int error) {
+        close(fd);
+        throw std::system_error(error, std::generic_category(), path.string());
+    };
+
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) != 0)
+        fail(errno);
+    // Only regular files have a size to map, anything else would silently
+    // map to an empty view
+    if (S_ISDIR(file_stat.st_mode))
+        fail(EISDIR);
+    if (!S_ISREG(file_stat.st_mode))
+        fail(ENODEV);
+
+    // mmap rejects zero-length mappings, an empty file maps to an empty view.
+    // Files under /proc and the like report a size of 0 but do have content.
+    size_ = file_stat.st_size;
+    if (size_ == 0) {
+        char byte;
+        ssize_t read_size = read(fd, &byte, 1);
+        if (read_size < 0)
+            fail(errno);
+        if (read_size > 0)
+            fail(ENODEV);
+    }
+    else if (size_ < kMapThreshold) {
+        // Copying a small file costs less than mapping it, and the copy
+        // can't fault when the file is truncated later
+        buffer_ = std::make_unique_for_overwrite<char[]>(size_);
+        std::size_t filled = 0;
+        while (filled < size_) {
+            ssize_t read_size = read(fd, buffer_.get() + filled,
+                                     size_ - filled);
+            if (read_size < 0 && errno == EINTR)
+                continue;
+            if (read_size < 0)
+                fail(errno);
+            if (read_size == 0)
+                break;  // Truncated since fstat
+            filled += read_size;
+        }
+        size_ = filled;
+    }
+    else {
+        address_ = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (address_ == MAP_FAILED) {
+            address_ = nullptr;
+            size_ = 0;
+            fail(errno);
+        }
+        madvise(address_, size_, MADV_SEQUENTIAL);
+    }
+    close(fd);
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+    : address_(std::exchange(other.address_, nullptr)),
+      buffer_(std::move(other.buffer_)),
+      size_(std::exchange(other.size_, 0)) {}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this != &other) {
+        release();
+        address_ = std::exchange(other.address_, nullptr);
+        buffer_ = std::move(other.buffer_);
+        size_ = std::exchange(other.size_, 0);
+    }
+    return *this;
+}
+
+MappedFile::~MappedFile() {
+    release();
+}
+
+void MappedFile::release() {
+    if (address_ != nullptr)
+        munmap(address_, size_);
+    address_ = nullptr;
+    buffer_.reset();
+    size_ = 0;
+}
+
+
+std::string_view MappedFile::data() const {
+    if (buffer_)
+        return std::string_view(buffer_.get(), size_);
+    return std::string_view(static_cast<const char*>(address_), size_);
+}
+
+std::span<const std::byte> MappedFile::bytes() const {
+    return std::as_bytes(std::span<const char>(data()));
+}
+
+std::size_t MappedFile::size() const {
+    return size_;
+}
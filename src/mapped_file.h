@@ -0,0 +1,40 @@
+#ifndef _MAPPED_FILE_H
+#define _MAPPED_FILE_H
+
+#include <cstddef>
+#include <filesystem>
+#include <memory>
+#include <span>
+#include <string_view>
+
+// Read-only view of a whole file. Views handed out by data() and bytes()
+// stay valid for as long as the MappedFile is alive.
+//
+// Files smaller than kMapThreshold are read into memory. Larger ones are
+// memory-mapped, and the mapping follows the file on disk: if another
+// process truncates it, touching the lost pages raises SIGBUS, and its
+// writes may show through. Only map files that nothing changes while the
+// MappedFile is alive.
+class MappedFile {
+public:
+    static constexpr std::size_t kMapThreshold = 1024 * 1024;
+
+    MappedFile(const std::filesystem::path& path);
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile();
+
+    std::string_view data() const;
+    std::span<const std::byte> bytes() const;
+    std::size_t size() const;
+
+private:
+    void release();
+    void *address_;
+    std::unique_ptr<char[]> buffer_;
+    std::size_t size_;
+};
+
+#endif // _MAPPED_FILE_H
@@ -1,45 +1,236 @@
+#include <algorithm>
 #include <cmath>
+#include <iterator>
+#include <mutex>
+#include <optional>
+#include <tuple>
 #include <openssl/sha.h>
 
 #include "metainfo.h"
+#include "bencode_schema.h"
+#include "mapped_file.h"
+#include "parallel_for.h"
 
 Piece::Piece(std::string_view hash_string, long length) : length(length) {
     for (char digit : hash_string)
         hash.push_back(std::byte(digit));
 }
 
-Metainfo::Metainfo(std::istream& input) : top_(Bencode::Parse(input)) {
-    if (top_.Type() != Bencode::ValueType::kDictionary)
-        throw MetainfoError(MetainfoError::ExceptionID::kTopLevelNotDict);
-
-    parse_announce();
-    parse_info();
-    parse_name();
-    parse_piece_length();
-
-    if (!info_.contains("length") && !info_.contains("files"))
-        throw MetainfoError(MetainfoError::ExceptionID::kMissingLengthAndFiles);
-    if (info_.contains("length") && info_.contains("files"))
-        throw MetainfoError(MetainfoError::ExceptionID::kBothLengthAndFiles);
-    if (info_.contains("length"))
-        parse_single_file();
-    else
-        parse_file_list();
-
-    if (!info_.contains("pieces"))
-        throw MetainfoError(MetainfoError::ExceptionID::kMissingPieces);
-    if (info_.at("pieces").Type() != Bencode::ValueType::kString)
-        throw MetainfoError(MetainfoError::ExceptionID::kPiecesNotString);
-    std::string_view pieces = info_.at("pieces").get_string();
-    if (pieces.length() == 0 || pieces.length() % 20 != 0)
-        throw MetainfoError(MetainfoError::ExceptionID::kPiecesInvalid);
-    for (auto it = pieces.begin(); it != pieces.end(); it += 20) {
-        std::string_view hash(it, it + 20);
-        piece_list_.push_back(Piece(hash, 0));
+// Each field keeps its own first error, load() reports them in the order
+// it checks the fields rather than the order they appear in the file
+struct Metainfo::FileFields {
+    Checked<long> length;
+    Checked<std::vector<std::string_view>> path;
+};
+
+struct Metainfo::InfoFields {
+    Checked<std::string_view> name;
+    Checked<long> piece_length;
+    std::optional<Checked<long>> length;
+    std::optional<Checked<std::vector<Checked<FileFields>>>> files;
+    Checked<std::string_view> pieces;
+    std::string_view encoding;
+};
+
+struct Metainfo::Fields {
+    Checked<std::string_view> announce;
+    Checked<InfoFields> info;
+};
+
+template <>
+struct BencodeSchema<Metainfo::FileFields> {
+    using Error = Metainfo::MetainfoError;
+    using ID = Error::ExceptionID;
+    static constexpr std::tuple fields {
+        BencodeField<&Metainfo::FileFields::length>(
+            "length", ID::kFileMissingLength, ID::kFileLengthNotInt),
+        BencodeField<&Metainfo::FileFields::path>(
+            "path", ID::kFileMissingPath, ID::kFilePathNotList,
+            ID::kSubPathNotString)
+    };
+};
+
+template <>
+struct BencodeSchema<Metainfo::InfoFields> {
+    using Error = Metainfo::MetainfoError;
+    using ID = Error::ExceptionID;
+    // length and files are optional here, one of them must be present
+    static constexpr std::tuple fields {
+        BencodeField<&Metainfo::InfoFields::name>(
+            "name", ID::kMissingName, ID::kNameNotString),
+        BencodeField<&Metainfo::InfoFields::piece_length>(
+            "piece length", ID::kMissingPieceLength, ID::kPieceLengthNotInt),
+        BencodeField<&Metainfo::InfoFields::length>(
+            "length", ID::kMissingLengthAndFiles, ID::kLengthNotInt),
+        BencodeField<&Metainfo::InfoFields::files>(
+            "files", ID::kMissingLengthAndFiles, ID::kFilesNotList,
+            ID::kFileNotDict),
+        BencodeField<&Metainfo::InfoFields::pieces>(
+            "pieces", ID::kMissingPieces, ID::kPiecesNotString)
+    };
+    static constexpr auto encoding = &Metainfo::InfoFields::encoding;
+};
+
+template <>
+struct BencodeSchema<Metainfo::Fields> {
+    using Error = Metainfo::MetainfoError;
+    using ID = Error::ExceptionID;
+    static constexpr std::tuple fields {
+        BencodeField<&Metainfo::Fields::announce>(
+            "announce", ID::kMissingAnnounce, ID::kAnnounceNotString),
+        BencodeField<&Metainfo::Fields::info>(
+            "info", ID::kMissingInfo, ID::kInfoNotDict)
+    };
+};
+
+// The buffer read from input lives until the delegated constructor returns
+Metainfo::Metainfo(std::istream& input)
+    : Metainfo(Source {std::string(std::istreambuf_iterator<char>(input),
+                                   std::istreambuf_iterator<char> {})}) {}
+
+// A null root can't be encoded, an empty buffer reports it as not a
+// dictionary. The info hash is taken over the re-encoded info dictionary.
+Metainfo::Metainfo(Bencode top)
+    : Metainfo(Source {top.Type() == Bencode::ValueType::kNull
+                       ? std::string() : top.Dump()}) {}
+
+Metainfo::Metainfo(Source source) {
+    Fields fields = BencodeDecode<Fields>(
+        source.buffer, MetainfoError::ExceptionID::kTopLevelNotDict);
+    if (Status status = load(fields); !status)
+        throw MetainfoError(status.error());
+}
+
+Metainfo Metainfo::FromBuffer(std::string_view buffer) {
+    return Metainfo(Source {buffer});
+}
+
+Metainfo Metainfo::FromFile(const std::filesystem::path& path) {
+    MappedFile file(path);
+    return Metainfo(Source {file.data()});
+}
+
+Metainfo::Result Metainfo::TryCreate(std::string_view buffer) {
+    auto fields = BencodeTryDecode<Fields>(
+        buffer, MetainfoError::ExceptionID::kTopLevelNotDict);
+    if (!fields)
+        return std::unexpected(std::visit(
+            [](auto failure) { return Failure(failure); }, fields.error()));
+
+    Metainfo output;
+    if (Status status = output.load(*fields); !status)
+        return std::unexpected(status.error());
+    return output;
+}
+
+Metainfo::Result Metainfo::TryFromFile(const std::filesystem::path& path) {
+    try {
+        MappedFile file(path);
+        return TryCreate(file.data());
+    } catch (const std::system_error& e) {
+        return std::unexpected(e.code());
     }
+}
+
+// Runs load(i) for every index on thread_count threads and passes each
+// result to store(i, result). The first exception thrown by either stops
+// the workers and is rethrown once they have joined.
+template <class Load, class Store>
+static void RunBatch(std::size_t count, std::size_t thread_count,
+                     Load load, Store store) {
+    ParallelFor(count, thread_count, 1, [&]() {
+        return [&](std::size_t i) { store(i, load(i)); };
+    });
+}
+
+// Results are collected in slots, Result has no empty state of its own
+static std::vector<Metainfo::Result> CollectResults(
+        std::vector<std::optional<Metainfo::Result>>& slots) {
+    std::vector<Metainfo::Result> results {};
+    results.reserve(slots.size());
+    for (std::optional<Metainfo::Result>& slot : slots)
+        results.push_back(std::move(*slot));
+    return results;
+}
+
+std::vector<Metainfo::Result> Metainfo::LoadBatch(
+        std::span<const std::filesystem::path> paths,
+        std::size_t thread_count) {
+    std::vector<std::optional<Result>> slots(paths.size());
+    RunBatch(paths.size(), thread_count,
+        [&](std::size_t i) { return TryFromFile(paths[i]); },
+        [&](std::size_t i, Result result) { slots[i] = std::move(result); });
+    return CollectResults(slots);
+}
+
+std::vector<Metainfo::Result> Metainfo::LoadBatch(
+        std::span<const std::string_view> buffers,
+        std::size_t thread_count) {
+    std::vector<std::optional<Result>> slots(buffers.size());
+    RunBatch(buffers.size(), thread_count,
+        [&](std::size_t i) { return TryCreate(buffers[i]); },
+        [&](std::size_t i, Result result) { slots[i] = std::move(result); });
+    return CollectResults(slots);
+}
+
+void Metainfo::LoadBatch(std::span<const std::filesystem::path> paths,
+                         const LoadCallback& on_loaded,
+                         std::size_t thread_count) {
+    std::mutex callback_mutex {};
+    RunBatch(paths.size(), thread_count,
+        [&](std::size_t i) { return TryFromFile(paths[i]); },
+        [&](std::size_t i, Result result) {
+            std::lock_guard lock(callback_mutex);
+            on_loaded(i, std::move(result));
+        });
+}
+
+void Metainfo::LoadBatch(std::span<const std::string_view> buffers,
+                         const LoadCallback& on_loaded,
+                         std::size_t thread_count) {
+    std::mutex callback_mutex {};
+    RunBatch(buffers.size(), thread_count,
+        [&](std::size_t i) { return TryCreate(buffers[i]); },
+        [&](std::size_t i, Result result) {
+            std::lock_guard lock(callback_mutex);
+            on_loaded(i, std::move(result));
+        });
+}
+
+Metainfo::Status Metainfo::load(const Fields& fields) {
+    if (!fields.announce)
+        return std::unexpected(fields.announce.error());
+    if (Status status = parse_announce(*fields.announce); !status)
+        return status;
+    if (!fields.info)
+        return std::unexpected(fields.info.error());
+    const InfoFields& info = *fields.info;
+    if (!info.name)
+        return std::unexpected(info.name.error());
+    name_ = *info.name;
+    if (!info.piece_length)
+        return std::unexpected(info.piece_length.error());
+    if (Status status = parse_piece_length(*info.piece_length); !status)
+        return status;
+
+    if (!info.length && !info.files)
+        return std::unexpected(
+            MetainfoError::ExceptionID::kMissingLengthAndFiles);
+    if (info.length && info.files)
+        return std::unexpected(MetainfoError::ExceptionID::kBothLengthAndFiles);
+    Status files = info.length ? parse_single_file(*info.length)
+                               : parse_file_list(*info.files);
+    if (!files)
+        return files;
+
+    if (!info.pieces)
+        return std::unexpected(info.pieces.error());
+    if (Status status = parse_pieces(*info.pieces); !status)
+        return status;
 
     if (ceil(total_length_ / (double)piece_length_) != piece_list_.size())
-        throw MetainfoError(MetainfoError::ExceptionID::kPiecesLengthMismatch);
+        return std::unexpected(
+            MetainfoError::ExceptionID::kPiecesLengthMismatch);
     for (std::size_t i = 0; i < piece_list_.size() - 1; i++)
         piece_list_[i].length = piece_length_;
     long final_length = total_length_ - (piece_list_.size()-1) * piece_length_;
@@ -58,110 +249,93 @@ Metainfo::Metainfo(std::istream& input) : top_(Bencode::Parse(input)) {
         }
     }
 
-    calculate_info_hash();
+    calculate_info_hash(info.encoding);
+    return {};
 }
 
-void Metainfo::parse_announce() {
-    if (!top_.contains("announce"))
-        throw MetainfoError(MetainfoError::ExceptionID::kMissingAnnounce);
-    if (top_.at("announce").Type() != Bencode::ValueType::kString)
-        throw MetainfoError(MetainfoError::ExceptionID::kAnnounceNotString);
-
-    announce_ = std::string(top_.at("announce").get_string());
+Metainfo::Status Metainfo::parse_announce(std::string_view announce) {
+    announce_ = std::string(announce);
+    // Url only reports a malformed reference by throwing, this is the one
+    // exception TryCreate catches on its way
     try {
         announce_.str();
     } catch (const Url::parse_error& e) {
-        throw MetainfoError(MetainfoError::ExceptionID::kAnnounceInvalidURL);
+        return std::unexpected(MetainfoError::ExceptionID::kAnnounceInvalidURL);
     }
 
     if (announce_.scheme() != "http")
-        throw MetainfoError(MetainfoError::ExceptionID::kAnnounceInvalidScheme);
+        return std::unexpected(
+            MetainfoError::ExceptionID::kAnnounceInvalidScheme);
 
     if (announce_.path().empty())
         announce_.path("/");
+    return {};
 }
 
-void Metainfo::parse_info() {
-    if (!top_.contains("info"))
-        throw MetainfoError(MetainfoError::ExceptionID::kMissingInfo);
-    if (top_.at("info").Type() != Bencode::ValueType::kDictionary)
-        throw MetainfoError(MetainfoError::ExceptionID::kInfoNotDict);
-    info_ = top_.at("info");
-}
-
-void Metainfo::parse_name() {
-    if (!info_.contains("name"))
-        throw MetainfoError(MetainfoError::ExceptionID::kMissingName);
-    if (info_.at("name").Type() != Bencode::ValueType::kString)
-        throw MetainfoError(MetainfoError::ExceptionID::kNameNotString);
-    name_ = info_.at("name").get_string();
-}
-
-void Metainfo::parse_piece_length() {
-    if (!info_.contains("piece length"))
-        throw MetainfoError(MetainfoError::ExceptionID::kMissingPieceLength);
-    if (info_.at("piece length").Type() != Bencode::ValueType::kInteger)
-        throw MetainfoError(MetainfoError::ExceptionID::kPieceLengthNotInt);
-    piece_length_ = info_.at("piece length").get_int();
+Metainfo::Status Metainfo::parse_piece_length(long piece_length) {
+    piece_length_ = piece_length;
     if (piece_length_ < 1)
-        throw MetainfoError(MetainfoError::ExceptionID::kPieceLengthInvalid);
+        return std::unexpected(MetainfoError::ExceptionID::kPieceLengthInvalid);
+    return {};
 }
 
-void Metainfo::parse_single_file() {
-    if (info_.at("length").Type() != Bencode::ValueType::kInteger)
-        throw MetainfoError(MetainfoError::ExceptionID::kLengthNotInt);
-    long length = info_.at("length").get_int();
-    if (length < 1)
-        throw MetainfoError(MetainfoError::ExceptionID::kLengthInvalid);
+Metainfo::Status Metainfo::parse_single_file(const Checked<long>& length) {
+    if (!length)
+        return std::unexpected(length.error());
+    if (*length < 1)
+        return std::unexpected(MetainfoError::ExceptionID::kLengthInvalid);
     file_list_.push_back(
-        File{std::string(get_name()), length, {}});
-    total_length_ = length;
+        File{std::string(get_name()), *length, {}});
+    total_length_ = *length;
+    return {};
 }
 
-void Metainfo::parse_file_list() {
-    if (info_.at("files").Type() != Bencode::ValueType::kList)
-        throw MetainfoError(MetainfoError::ExceptionID::kFilesNotList);
-    if (info_.at("files").empty())
-        throw MetainfoError(MetainfoError::ExceptionID::kFilesEmpty);
+Metainfo::Status Metainfo::parse_file_list(
+        const Checked<std::vector<Checked<FileFields>>>& files) {
+    if (!files)
+        return std::unexpected(files.error());
+    if (files->empty())
+        return std::unexpected(MetainfoError::ExceptionID::kFilesEmpty);
     total_length_ = 0;
-    for (const Bencode& file : info_.at("files")) {
+    file_list_.reserve(files->size());
+    for (const Checked<FileFields>& file : *files) {
+        if (!file)
+            return std::unexpected(file.error());
+        if (!file->length)
+            return std::unexpected(file->length.error());
         file_list_.push_back(File {});
-        if (file.Type() != Bencode::ValueType::kDictionary)
-            throw MetainfoError(MetainfoError::ExceptionID::kFileNotDict);
-
-        if (!file.contains("length"))
-            throw MetainfoError(
-                MetainfoError::ExceptionID::kFileMissingLength);
-        if (file.at("length").Type() != Bencode::ValueType::kInteger)
-            throw MetainfoError(
-                MetainfoError::ExceptionID::kFileLengthNotInt);
-        file_list_.back().length = file.at("length").get_int();
-        total_length_ += file.at("length").get_int();
-
-        if (!file.contains("path"))
-            throw MetainfoError(
-                MetainfoError::ExceptionID::kFileMissingPath);
-        if (file.at("path").Type() != Bencode::ValueType::kList)
-            throw MetainfoError(
-                MetainfoError::ExceptionID::kFilePathNotList);
-        if (file.at("path").empty())
-            throw MetainfoError(MetainfoError::ExceptionID::kFilePathEmpty);
-        for (const Bencode& sub_path : file.at("path")) {
-            if (sub_path.Type() != Bencode::ValueType::kString)
-                throw MetainfoError(
-                    MetainfoError::ExceptionID::kSubPathNotString);
-            file_list_.back().path += std::string(sub_path.get_string()) + '/';
+        file_list_.back().length = *file->length;
+        total_length_ += *file->length;
+
+        if (!file->path)
+            return std::unexpected(file->path.error());
+        if (file->path->empty())
+            return std::unexpected(MetainfoError::ExceptionID::kFilePathEmpty);
+        for (std::string_view sub_path : *file->path) {
+            file_list_.back().path += sub_path;
+            file_list_.back().path += '/';
         }
         file_list_.back().path.pop_back();
     }
+    return {};
+}
+
+Metainfo::Status Metainfo::parse_pieces(std::string_view pieces) {
+    if (pieces.length() == 0 || pieces.length() % 20 != 0)
+        return std::unexpected(MetainfoError::ExceptionID::kPiecesInvalid);
+    piece_list_.reserve(pieces.length() / 20);
+    for (auto it = pieces.begin(); it != pieces.end(); it += 20) {
+        std::string_view hash(it, it + 20);
+        piece_list_.push_back(Piece(hash, 0));
+    }
+    return {};
 }
 
-void Metainfo::calculate_info_hash() {
+void Metainfo::calculate_info_hash(std::string_view info_bytes) {
     info_hash_.resize(20);
-    std::string info_string = info_.Dump();
     SHA1(
-        reinterpret_cast<const unsigned char*>(info_string.data()),
-        info_string.size(),
+        reinterpret_cast<const unsigned char*>(info_bytes.data()),
+        info_bytes.size(),
         reinterpret_cast<unsigned char *>(info_hash_.data())
     );
 }
@@ -1,7 +1,15 @@
 #ifndef _METAINFO_H
 #define _METAINFO_H
 
+#include <expected>
+#include <functional>
+#include <span>
 #include <string>
+#include <string_view>
+#include <filesystem>
+#include <system_error>
+#include <variant>
+#include <vector>
 #include "../lib/CxxUrl/url.hpp"
 
 #include "bencode.h"
@@ -21,6 +29,11 @@ struct File {
 class Metainfo {
 public:
     Metainfo(std::istream& input);
+    explicit Metainfo(Bencode top);
+    static Metainfo FromBuffer(std::string_view buffer);
+    // A torrent past MappedFile::kMapThreshold is mapped, it must not be
+    // truncated before FromFile returns
+    static Metainfo FromFile(const std::filesystem::path& path);
     const Url& get_announce() const;
     std::string_view get_name() const;
     const std::vector<File>& get_file_list () const;
@@ -65,18 +78,63 @@ public:
         const char* what() const noexcept;
         const ExceptionID id_;
     };
+
+    // Non-throwing FromBuffer and FromFile. A failure holds the ID of the
+    // Bencode::ParseError or MetainfoError they would throw, or the error
+    // of a file that can't be read. Url reports a malformed announce only by
+    // throwing, that one exception is caught inside and never escapes.
+    using Failure = std::variant<Bencode::ParseFailure,
+                                 MetainfoError::ExceptionID, std::error_code>;
+    using Result = std::expected<Metainfo, Failure>;
+    static Result TryCreate(std::string_view buffer);
+    static Result TryFromFile(const std::filesystem::path& path);
+
+    // Loads many torrents on thread_count threads, all hardware threads
+    // when 0, and returns the results in input order
+    static std::vector<Result> LoadBatch(
+        std::span<const std::filesystem::path> paths,
+        std::size_t thread_count = 0);
+    static std::vector<Result> LoadBatch(
+        std::span<const std::string_view> buffers,
+        std::size_t thread_count = 0);
+    // Hands each result to on_loaded with its input index as soon as it is
+    // ready. Calls come from the worker threads, one at a time.
+    using LoadCallback = std::function<void(std::size_t, Result)>;
+    static void LoadBatch(std::span<const std::filesystem::path> paths,
+                          const LoadCallback& on_loaded,
+                          std::size_t thread_count = 0);
+    static void LoadBatch(std::span<const std::string_view> buffers,
+                          const LoadCallback& on_loaded,
+                          std::size_t thread_count = 0);
 private:
-    void parse_announce();
-    void parse_info();
-    void parse_name();
-    void parse_piece_length();
-    void parse_single_file();
-    void parse_file_list();
-    void calculate_info_hash();
-    Bencode top_;
+    // Buffer to parse, kept apart from Bencode's converting constructors
+    struct Source {
+        std::string_view buffer;
+    };
+    // Layout of the dictionaries, decoded by BencodeDecode in one pass
+    struct FileFields;
+    struct InfoFields;
+    struct Fields;
+    template <class T>
+    friend struct BencodeSchema;
+    Metainfo() = default;
+    explicit Metainfo(Source source);
+    // Checks report the first failure instead of throwing it, in the same
+    // order whatever the order of the fields in the file
+    using Status = std::expected<void, MetainfoError::ExceptionID>;
+    template <class V>
+    using Checked = std::expected<V, MetainfoError::ExceptionID>;
+    Status load(const Fields& fields);
+    Status parse_announce(std::string_view announce);
+    Status parse_piece_length(long piece_length);
+    Status parse_single_file(const Checked<long>& length);
+    Status parse_file_list(
+        const Checked<std::vector<Checked<FileFields>>>& files);
+    Status parse_pieces(std::string_view pieces);
+    // Hashes the info dictionary as it appears in the parsed buffer
+    void calculate_info_hash(std::string_view info_bytes);
     Url announce_;
-    Bencode info_;
-    std::string_view name_;
+    std::string name_;
     std::vector<File> file_list_;
     long piece_length_;
     std::vector<Piece> piece_list_;
@@ -0,0 +1,64 @@
+#ifndef _PARALLEL_FOR_H
+#define _PARALLEL_FOR_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Number of threads to use when thread_count were asked for, all hardware
+// threads when 0
+inline std::size_t ResolveThreadCount(std::size_t thread_count) {
+    if (thread_count == 0)
+        return std::max(1u, std::thread::hardware_concurrency());
+    return thread_count;
+}
+
+// Hands the indices below count out to thread_count threads, never more
+// than count, batch indices at a time. The calling thread is one of them.
+// Each thread calls make_work() once and passes every index it claims to
+// the callable it returns, which may keep state of its own. The first
+// exception thrown stops the threads and is rethrown once they have joined.
+template <class MakeWork>
+void ParallelFor(std::size_t count, std::size_t thread_count,
+                 std::size_t batch, MakeWork make_work) {
+    thread_count = std::min(ResolveThreadCount(thread_count), count);
+
+    std::atomic<std::size_t> next {0};
+    std::atomic<bool> failed {false};
+    std::exception_ptr error {};
+    std::mutex error_mutex {};
+    auto run = [&]() {
+        try {
+            auto work = make_work();
+            while (!failed) {
+                std::size_t first = next.fetch_add(batch);
+                if (first >= count)
+                    return;
+                std::size_t last = std::min(first + batch, count);
+                for (std::size_t i = first; i < last; i++)
+                    work(i);
+            }
+        }
+        catch (...) {
+            std::lock_guard lock(error_mutex);
+            if (!error)
+                error = std::current_exception();
+            failed = true;
+        }
+    };
+    {
+        std::vector<std::jthread> workers {};
+        for (std::size_t i = 1; i < thread_count; i++)
+            workers.emplace_back(run);
+        run();
+    }
+
+    if (error)
+        std::rethrow_exception(error);
+}
+
+#endif // _PARALLEL_FOR_H
@@ -0,0 +1,59 @@
+#ifndef _TEST_MALFORMED_INPUTS_H
+#define _TEST_MALFORMED_INPUTS_H
+
+#include <gtest/gtest.h>
+
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "../src/bencode.h"
+
+// Inputs Bencode::Parse refuses, covering every ParseError it can raise
+// short of kNestingTooDeep
+inline const std::vector<std::string>& malformed_inputs() {
+    static const std::vector<std::string> inputs {
+        "a", "-1", "01:f", "00:", "1a", "3foo", "3:fo", "11:Hello world3:foo",
+        "0", "3", "i", "ie", "i6", "i6a", "ia6e", "i-e", "i03e", "i-03e",
+        "i-0e", "i-0", "i00", "i9223372036854775808e",
+        "i-9223372036854775809e", "l", "lae", "d", "dae", "di0e3:fooe",
+        "d3:fooae", "d3:fooe", "d3:foo3:bar", "d3:fooi2e3:foo5:helloe",
+        "d3:fooi2e3:bar5:helloe", "d1:bi0e1:bi0e1:ai0ee"
+    };
+    return inputs;
+}
+
+// Calls check(input, id) for each malformed input, id being the ParseError
+// that Bencode::Parse raises for it
+template <class Check>
+void for_each_malformed_input(Check check) {
+    for (const std::string& input : malformed_inputs()) {
+        SCOPED_TRACE(input);
+        std::optional<Bencode::ParseError::ExceptionID> expected_id {};
+        try {
+            Bencode::Parse(std::string_view(input));
+        }
+        catch (const Bencode::ParseError& e) {
+            expected_id = e.id_;
+        }
+        ASSERT_TRUE(expected_id.has_value())
+            << "Expected Bencode::ParseError from Bencode::Parse";
+        check(input, *expected_id);
+    }
+}
+
+// Checks that parse() raises a ParseError with expected_id
+template <class Parse>
+void expect_parse_error(Bencode::ParseError::ExceptionID expected_id,
+                        Parse parse) {
+    try {
+        parse();
+        ADD_FAILURE() << "Expected Bencode::ParseError";
+    }
+    catch (const Bencode::ParseError& e) {
+        EXPECT_EQ(e.id_, expected_id);
+    }
+}
+
+#endif // _TEST_MALFORMED_INPUTS_H
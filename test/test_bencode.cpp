@@ -1,6 +1,13 @@
 #include <gtest/gtest.h>
 #include "../src/bencode.h"
 
+#include <format>
+#include <fstream>
+#include <limits>
+#include <memory_resource>
+
+#include "malformed_inputs.h"
+
 //
 // Initialization
 //
@@ -194,6 +201,15 @@ TEST(BencodeTest, listFromNull) {
     EXPECT_EQ(dut[0].Type(), Bencode::ValueType::kNull);
 }
 
+TEST(BencodeTest, listEmplaceBack) {
+    Bencode dut;
+    Bencode& elem = dut.emplace_back("Hello world");
+    EXPECT_EQ(&elem, &dut.at(0));
+    dut.emplace_back(10l);
+    dut.emplace_back();
+    EXPECT_EQ(dut, Bencode({"Hello world", 10, {}}));
+}
+
 // Dictionary modifiers
 
 TEST(BencodeTest, clearFilledDict) {
@@ -248,6 +264,75 @@ TEST(BencodeTest, dictFromNull) {
     EXPECT_EQ(dut["foo"].Type(), Bencode::ValueType::kNull);
 }
 
+TEST(BencodeTest, dictEmplace) {
+    Bencode dut;
+    Bencode& value = dut.emplace("foo", 10l);
+    EXPECT_EQ(&value, &dut.at("foo"));
+    dut.emplace("bar", "Hello world");
+    dut.emplace("foo", Bencode::List {});
+    EXPECT_EQ(dut, Bencode({"bar", "Hello world", "foo", Bencode::List {}}));
+}
+
+TEST(BencodeTest, emplaceWrongType) {
+    Bencode dut = Bencode::Dict {};
+    EXPECT_THROW({dut.emplace_back(1l);}, std::bad_variant_access);
+    dut = Bencode::List {};
+    EXPECT_THROW({dut.emplace("foo", 1l);}, std::bad_variant_access);
+}
+
+// Flat dictionary
+
+TEST(BencodeTest, dictInitializerSortsKeys) {
+    Bencode::Dict dut {{"foo", 1}, {"bar", 2}, {"hello", 3}, {"bar", 4}};
+    ASSERT_EQ(dut.size(), 3);
+    std::vector<std::string> key_list {"bar", "foo", "hello"};
+    std::vector<long> value_list {2, 1, 3};
+    int i = 0;
+    for (const auto& [key, value] : dut) {
+        EXPECT_EQ(key, key_list[i]);
+        EXPECT_EQ(value.get_int(), value_list[i]);
+        i++;
+    }
+}
+
+TEST(BencodeTest, dictInsertKeepsOrder) {
+    Bencode::Dict dut;
+    dut["hello"] = 1;
+    dut["bar"] = 2;
+    dut["foo"] = 3;
+    dut["bar"] = 4;
+    ASSERT_EQ(dut.size(), 3);
+    EXPECT_EQ(dut.begin()->first, "bar");
+    EXPECT_EQ(dut.begin()->second.get_int(), 4l);
+    EXPECT_EQ((dut.begin() + 1)->first, "foo");
+    EXPECT_EQ((dut.begin() + 2)->first, "hello");
+}
+
+TEST(BencodeTest, dictLookup) {
+    Bencode::Dict dut {{"bar", 2}, {"foo", 1}};
+    EXPECT_TRUE(dut.contains("bar"));
+    EXPECT_FALSE(dut.contains("baz"));
+    EXPECT_EQ(dut.find("foo")->second.get_int(), 1l);
+    EXPECT_EQ(dut.find("baz"), dut.end());
+    EXPECT_THROW({dut.at("baz");}, std::out_of_range);
+}
+
+TEST(BencodeTest, dictAppend) {
+    Bencode::Dict dut;
+    dut.reserve(2);
+    dut.append("bar") = 1;
+    dut.append("foo") = 2;
+    EXPECT_EQ(dut, (Bencode::Dict {{"foo", 2}, {"bar", 1}}));
+    EXPECT_EQ(dut.at("foo").get_int(), 2l);
+}
+
+TEST(BencodeTest, dictEraseKeepsOrder) {
+    Bencode::Dict dut {{"a", 1}, {"b", 2}, {"c", 3}};
+    EXPECT_EQ(dut.erase("b"), 1);
+    EXPECT_EQ(dut.erase("b"), 0);
+    EXPECT_EQ(dut, (Bencode::Dict {{"a", 1}, {"c", 3}}));
+}
+
 // Incorrect accesses
 
 TEST(BencodeTest, nonStringAsString) {
@@ -432,6 +517,47 @@ TEST(BencodeTest, itemIterationOverNonDict) {
     EXPECT_THROW({dut.items();}, std::bad_variant_access);
 }
 
+TEST(BencodeTest, iterateOverListByReference) {
+    static_assert(std::input_iterator<Bencode::const_iterator>);
+    Bencode dut {Bencode {0l, 1}, "foo", 2};
+    auto it = dut.begin();
+    EXPECT_EQ(&*it, &dut.at(0));
+    EXPECT_EQ(&*(++it), &dut.at(1));
+    EXPECT_EQ(&*(it++), &dut.at(1));
+    EXPECT_EQ(&*it, &dut.at(2));
+    EXPECT_EQ(++it, dut.end());
+}
+
+TEST(BencodeTest, iterateOverDictKeysHeldByIterator) {
+    Bencode dut {"foo", 1l, "bar", 2l};
+    const Bencode::const_iterator it = dut.begin();
+    const Bencode *key = &*it;
+    EXPECT_EQ(&*it, key);
+    EXPECT_EQ(key->get_string(), "bar");
+    Bencode::const_iterator copy = it;
+    EXPECT_EQ(copy, it);
+    EXPECT_EQ((++copy)->get_string(), "foo");
+    EXPECT_EQ(key->get_string(), "bar");
+    EXPECT_EQ(++copy, dut.end());
+}
+
+TEST(BencodeTest, iterateOverListWithRanges) {
+    Bencode dut {0l, 1, 2, 3};
+    auto found = std::ranges::find_if(dut, [](const Bencode& elem) {
+        return elem.get_int() == 2;
+    });
+    EXPECT_EQ(&*found, &dut.at(2));
+    EXPECT_EQ(std::ranges::distance(dut), 4);
+}
+
+TEST(BencodeTest, itemIterationBorrowsDict) {
+    Bencode dut {"foo", Bencode {0l, 1}, "bar", "baz"};
+    auto items = dut.items();
+    EXPECT_EQ(&items.begin()->second, &dut.at("bar"));
+    EXPECT_EQ(&(items.begin() + 1)->second, &dut.at("foo"));
+    EXPECT_EQ(items.end() - items.begin(), 2);
+}
+
 // Lookup
 
 TEST(BencodeTest, containsExistingElem) {
@@ -455,6 +581,30 @@ TEST(BencodeTest, containsNonDict) {
     EXPECT_FALSE(dut.contains("bar"));
 }
 
+TEST(BencodeTest, lookupWithStringView) {
+    // Views into a larger buffer are not null terminated
+    std::string_view buffer = "barfoo";
+    std::string_view bar = buffer.substr(0, 3);
+    std::string_view foo = buffer.substr(3);
+    Bencode dut {"foo", 65, "bar", {}};
+    EXPECT_TRUE(dut.contains(bar));
+    EXPECT_FALSE(dut.contains(buffer));
+    EXPECT_EQ(dut.at(foo).get_int(), 65);
+    dut[bar] = 10;
+    EXPECT_EQ(dut.at("bar").get_int(), 10);
+    EXPECT_EQ(dut.erase(foo), 1);
+    EXPECT_EQ(dut, Bencode({"bar", 10}));
+}
+
+TEST(BencodeTest, lookupWithStdString) {
+    const std::string key = "foo";
+    Bencode dut {key, 65};
+    EXPECT_TRUE(dut.contains(key));
+    EXPECT_EQ(dut.at(key).get_int(), 65);
+    dut[key] = 10;
+    EXPECT_EQ(dut.erase(key), 1);
+}
+
 // Parsing
 
 void check_parse_exception(std::istream& input,
@@ -515,6 +665,12 @@ TEST(BencodeTest, parseStringNoColon) {
         Bencode::ParseError::ExceptionID::kStringMissingColon);
 }
 
+TEST(BencodeTest, parseStringLengthOverflow) {
+    std::istringstream input("18446744073709551616:foo");
+    check_parse_exception(input,
+        Bencode::ParseError::ExceptionID::kUnexpectedEOF);
+}
+
 TEST(BencodeTest, parseStringUnexpectedEOF) {
     std::istringstream input("3:fo");
     check_parse_exception(input,
@@ -595,6 +751,55 @@ TEST(BencodeTest, parseIntegerNegative) {
     EXPECT_EQ(output.get_int(), -89l);
 }
 
+TEST(BencodeTest, parseIntegerZero) {
+    std::istringstream input("i0e");
+    Bencode output = Bencode::Parse(input);
+    EXPECT_EQ(output.get_int(), 0l);
+}
+
+TEST(BencodeTest, parseIntegerLeading0) {
+    std::istringstream input("i03e");
+    check_parse_exception(input,
+        Bencode::ParseError::ExceptionID::kLeading0);
+}
+
+TEST(BencodeTest, parseIntegerNegativeLeading0) {
+    std::istringstream input("i-03e");
+    check_parse_exception(input,
+        Bencode::ParseError::ExceptionID::kLeading0);
+}
+
+TEST(BencodeTest, parseIntegerNegative0) {
+    std::istringstream input("i-0e");
+    check_parse_exception(input,
+        Bencode::ParseError::ExceptionID::kLeading0);
+}
+
+TEST(BencodeTest, parseIntegerSignOnly) {
+    std::istringstream input("i-e");
+    check_parse_exception(input,
+        Bencode::ParseError::ExceptionID::kIntegerNonDecimal);
+}
+
+TEST(BencodeTest, parseIntegerLimits) {
+    EXPECT_EQ(Bencode::Parse(std::string_view("i9223372036854775807e"))
+                  .get_int(), std::numeric_limits<long>::max());
+    EXPECT_EQ(Bencode::Parse(std::string_view("i-9223372036854775808e"))
+                  .get_int(), std::numeric_limits<long>::min());
+}
+
+TEST(BencodeTest, parseIntegerOverflow) {
+    std::vector<std::string> input_list {
+        "i9223372036854775808e", "i-9223372036854775809e",
+        "i18446744073709551616e", "i100000000000000000000000e"
+    };
+    for (const std::string& input : input_list) {
+        std::istringstream stream(input);
+        check_parse_exception(stream,
+            Bencode::ParseError::ExceptionID::kIntegerNonDecimal);
+    }
+}
+
 // List
 
 TEST(BencodeTest, parseListEmptyEOF) {
@@ -751,6 +956,221 @@ TEST(BencodeTest, parseDictMultiElem) {
     EXPECT_EQ(output.at("foo").get_string(), "hello");
 }
 
+// Nesting
+
+TEST(BencodeTest, parseNestingAtDefaultLimit) {
+    std::string input = std::string(Bencode::kDefaultMaxDepth, 'l')
+        + std::string(Bencode::kDefaultMaxDepth, 'e');
+    Bencode output = Bencode::Parse(std::string_view(input));
+    const Bencode *elem = &output;
+    for (std::size_t i = 1; i < Bencode::kDefaultMaxDepth; i++)
+        elem = &elem->at(0);
+    EXPECT_TRUE(elem->empty());
+}
+
+TEST(BencodeTest, parseNestingTooDeep) {
+    std::string input = std::string(Bencode::kDefaultMaxDepth + 1, 'l')
+        + std::string(Bencode::kDefaultMaxDepth + 1, 'e');
+    std::istringstream stream(input);
+    check_parse_exception(stream,
+        Bencode::ParseError::ExceptionID::kNestingTooDeep);
+}
+
+TEST(BencodeTest, parseNestingHostileInput) {
+    std::istringstream input(std::string(10'000'000, 'l'));
+    check_parse_exception(input,
+        Bencode::ParseError::ExceptionID::kNestingTooDeep);
+}
+
+TEST(BencodeTest, parseNestingCustomLimit) {
+    std::string_view input = "d3:fooli1ed3:barleeee";
+    EXPECT_THROW({Bencode::Parse(input, 3);}, Bencode::ParseError);
+    Bencode output = Bencode::Parse(input, 4);
+    EXPECT_TRUE(output.at("foo").at(1).at("bar").empty());
+    EXPECT_EQ(Bencode::Parse(std::string_view("i1e"), 0).get_int(), 1l);
+    EXPECT_THROW({Bencode::Parse(std::string_view("le"), 0);},
+                 Bencode::ParseError);
+}
+
+TEST(BencodeTest, parseNestingBeyondDefaultLimit) {
+    std::size_t depth = 10000;
+    std::string input = std::string(depth, 'l') + "i7e"
+        + std::string(depth, 'e');
+    Bencode output = Bencode::Parse(std::string_view(input), depth);
+    const Bencode *elem = &output;
+    for (std::size_t i = 0; i < depth; i++)
+        elem = &elem->at(0);
+    EXPECT_EQ(elem->get_int(), 7l);
+}
+
+// Memory resource
+
+class CountingResource : public std::pmr::memory_resource {
+public:
+    std::size_t allocations = 0;
+    std::size_t deallocations = 0;
+private:
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+        allocations++;
+        return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+    }
+    void do_deallocate(void *p, std::size_t bytes,
+                       std::size_t alignment) override {
+        deallocations++;
+        std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+    }
+    bool do_is_equal(
+            const std::pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+};
+
+TEST(BencodeTest, parseWithResource) {
+    std::string_view input = "d3:bard1:ali1ei2eee3:fooi1ee";
+    CountingResource resource;
+    {
+        Bencode output = Bencode::Parse(input, resource);
+        EXPECT_EQ(output, Bencode::Parse(input));
+        EXPECT_GT(resource.allocations, 0);
+    }
+    EXPECT_EQ(resource.allocations, resource.deallocations);
+}
+
+TEST(BencodeTest, parseWithMonotonicArena) {
+    std::string_view input = "d3:bard1:ali1ei2eee3:fooi1ee";
+    Bencode copy;
+    {
+        std::pmr::monotonic_buffer_resource arena;
+        Bencode output = Bencode::Parse(input, arena);
+        copy = output;
+    }
+    EXPECT_EQ(copy.at("bar").at("a").at(1).get_int(), 2l);
+    EXPECT_EQ(copy.at("foo").get_int(), 1l);
+}
+
+TEST(BencodeTest, parseStringsFromResource) {
+    CountingResource short_resource;
+    Bencode::Parse(std::string_view("l1:ae"), short_resource);
+    CountingResource long_resource;
+    std::string input = "l64:" + std::string(64, 'a') + "e";
+    Bencode output = Bencode::Parse(std::string_view(input), long_resource);
+    // The long string is the only difference, small ones fit in place
+    EXPECT_EQ(long_resource.allocations, short_resource.allocations + 1);
+}
+
+TEST(BencodeTest, copyLeavesResource) {
+    CountingResource resource;
+    Bencode output = Bencode::Parse(std::string_view("lli1eee"), resource);
+    std::size_t allocations = resource.allocations;
+    Bencode copy = output;
+    copy.push_back(2);
+    EXPECT_EQ(resource.allocations, allocations);
+}
+
+// Routes default resource allocations, i.e. those of programmatically built
+// containers, to a counting resource for the lifetime of the scope
+class DefaultResourceScope {
+public:
+    DefaultResourceScope(std::pmr::memory_resource *resource)
+        : previous_(std::pmr::set_default_resource(resource)) {}
+    ~DefaultResourceScope() { std::pmr::set_default_resource(previous_); }
+private:
+    std::pmr::memory_resource *previous_;
+};
+
+TEST(BencodeTest, constructFromTemporaryContainers) {
+    CountingResource resource;
+    DefaultResourceScope scope(&resource);
+    Bencode::List list {1l, 2l};
+    Bencode::Dict dict {{"foo", 1l}};
+    std::size_t allocations = resource.allocations;
+    Bencode list_node(std::move(list));
+    Bencode dict_node(std::move(dict));
+    EXPECT_EQ(resource.allocations, allocations);
+}
+
+TEST(BencodeTest, constructFromTemporaryString) {
+    std::pmr::string value(64, 'a');
+    const char *buffer = value.data();
+    Bencode dut(std::move(value));
+    EXPECT_EQ(dut.get_string().data(), buffer);
+}
+
+TEST(BencodeTest, pushBackTemporaryTree) {
+    CountingResource resource;
+    DefaultResourceScope scope(&resource);
+    Bencode elem {Bencode {1l, 2l}, Bencode::Dict {{"foo", 1l}}};
+    Bencode dut;
+    std::size_t allocations = resource.allocations;
+    dut.push_back(std::move(elem));
+    // Only the outer list's own buffer
+    EXPECT_EQ(resource.allocations, allocations + 1);
+}
+
+TEST(BencodeTest, assignTemporaryTree) {
+    CountingResource resource;
+    DefaultResourceScope scope(&resource);
+    Bencode dut = Bencode::Dict {};
+    dut["foo"];
+    Bencode value {Bencode {1l, 2l}, 3l};
+    std::size_t allocations = resource.allocations;
+    dut["foo"] = std::move(value);
+    EXPECT_EQ(resource.allocations, allocations);
+}
+
+TEST(BencodeTest, emplaceDoesNotCopy) {
+    CountingResource resource;
+    DefaultResourceScope scope(&resource);
+    Bencode dut;
+    dut.emplace("files", Bencode::List {});
+    std::size_t allocations = resource.allocations;
+    Bencode& files = dut.emplace("files", Bencode::List {});
+    EXPECT_EQ(resource.allocations, allocations);
+    files.emplace_back(Bencode::List {1l, 2l});
+    // The inner list's buffer and the files list's own buffer
+    EXPECT_EQ(resource.allocations, allocations + 2);
+}
+
+TEST(BencodeTest, initializerListCopiesOnce) {
+    CountingResource resource;
+    DefaultResourceScope scope(&resource);
+    Bencode value {1l, 2l};
+    std::size_t allocations = resource.allocations;
+    Bencode dut {"foo", std::move(value), "bar", 3l};
+    // The dictionary's buffer and one copy out of the initializer list
+    EXPECT_EQ(resource.allocations, allocations + 2);
+}
+
+// Keys
+
+TEST(BencodeTest, parseSharesEqualKeys) {
+    Bencode output = Bencode::Parse(
+        std::string_view("ld6:lengthi1eed6:lengthi2eee"));
+    const Bencode::Key& first = output.at(0).items().begin()->first;
+    const Bencode::Key& second = output.at(1).items().begin()->first;
+    EXPECT_EQ(&first.str(), &second.str());
+}
+
+TEST(BencodeTest, keyTableSharesKeysAcrossDocuments) {
+    Bencode::KeyTable keys;
+    std::pmr::memory_resource& resource = *std::pmr::get_default_resource();
+    Bencode first = Bencode::Parse("d4:porti1ee", resource, keys);
+    Bencode second = Bencode::Parse("d2:ip0:4:porti2ee", resource, keys);
+    EXPECT_EQ(keys.size(), 2);
+    EXPECT_EQ(&first.items().begin()->first.str(),
+              &std::next(second.items().begin())->first.str());
+}
+
+TEST(BencodeTest, keyComparison) {
+    Bencode::Key key("foo");
+    EXPECT_EQ(key, "foo");
+    EXPECT_EQ(key, std::string("foo"));
+    EXPECT_EQ(key, Bencode::Key(std::string("foo")));
+    EXPECT_NE(key, "fo");
+    EXPECT_LT(key, "goo");
+    EXPECT_GT(key, "bar");
+}
+
 TEST(BencodeTest, extractionOperator) {
     std::istringstream input("11:Hello world");
     Bencode output {};
@@ -758,6 +1178,325 @@ TEST(BencodeTest, extractionOperator) {
     EXPECT_EQ(output.get_string(), "Hello world");
 }
 
+TEST(BencodeTest, parseBuffer) {
+    Bencode output = Bencode::Parse(std::string_view("d3:bari2e3:fool1:aee"));
+    EXPECT_EQ(output.at("bar").get_int(), 2l);
+    EXPECT_EQ(output.at("foo").at(0).get_string(), "a");
+}
+
+TEST(BencodeTest, parseRecordsSourceRange) {
+    std::string_view input = "d3:barli1e0:e3:fooi-2ee";
+    Bencode output = Bencode::Parse(input);
+    auto slice = [&](const Bencode& node) {
+        std::optional<Bencode::SourceRange> range = node.source_range();
+        EXPECT_TRUE(range.has_value());
+        return input.substr(range->begin, range->end - range->begin);
+    };
+    EXPECT_EQ(slice(output), input);
+    EXPECT_EQ(slice(output.at("bar")), "li1e0:e");
+    EXPECT_EQ(slice(output.at("bar").at(0)), "i1e");
+    EXPECT_EQ(slice(output.at("bar").at(1)), "0:");
+    EXPECT_EQ(slice(output.at("foo")), "i-2e");
+}
+
+TEST(BencodeTest, sourceRangeOfBuiltNode) {
+    Bencode dut {"foo", 1l};
+    EXPECT_FALSE(dut.source_range().has_value());
+    EXPECT_FALSE(dut.at("foo").source_range().has_value());
+}
+
+TEST(BencodeTest, mutationDropsSourceRange) {
+    Bencode dut = Bencode::Parse(std::string_view("d3:fooli1eee"));
+    Bencode copy = dut;
+    EXPECT_TRUE(copy.source_range().has_value());
+    dut["foo"].push_back(2l);
+    EXPECT_FALSE(dut.source_range().has_value());
+    EXPECT_FALSE(dut.at("foo").source_range().has_value());
+    EXPECT_TRUE(dut.at("foo").at(0).source_range().has_value());
+}
+
+TEST(BencodeTest, parseBufferEmpty) {
+    Bencode output = Bencode::Parse(std::string_view(""));
+    EXPECT_EQ(output.Type(), Bencode::ValueType::kNull);
+}
+
+TEST(BencodeTest, parseBufferErrorsMatchStream) {
+    for_each_malformed_input([](const std::string& input,
+                                Bencode::ParseError::ExceptionID id) {
+        std::istringstream stream(input);
+        expect_parse_error(id, [&]() { Bencode::Parse(stream); });
+    });
+}
+
+TEST(BencodeTest, parseFile) {
+    Bencode data {"foo", Bencode::List {1, "bar"}, "hello", "world"};
+    std::filesystem::path path =
+        std::filesystem::temp_directory_path() / "ftor_bencode_parse_file";
+    std::ofstream(path, std::ios::binary) << data;
+    EXPECT_EQ(Bencode::ParseFile(path), data);
+    std::filesystem::remove(path);
+}
+
+TEST(BencodeTest, parseFileMissing) {
+    EXPECT_THROW({Bencode::ParseFile("/nonexistent/ftor_bencode");},
+                 std::system_error);
+}
+
+// Parallel
+
+// Torrent with a file list large enough to be split across threads
+std::string parallel_torrent_input() {
+    Bencode files = Bencode::List {};
+    for (long i = 0; i < 20'000; i++)
+        files.push_back(Bencode {
+            "length", i,
+            "path", Bencode::List {"dir", std::format("file_{}", i)}
+        });
+    Bencode info {"files", files, "name", "foo"};
+    return Bencode {"announce", "http://test.org", "info", info}.Dump();
+}
+
+TEST(BencodeTest, parseParallelMatchesParse) {
+    std::string input = parallel_torrent_input();
+    Bencode expected = Bencode::Parse(std::string_view(input));
+    for (std::size_t thread_count : {2, 4, 7}) {
+        Bencode output = Bencode::ParseParallel(input, thread_count);
+        EXPECT_EQ(output, expected);
+        const Bencode& file = output.at("info").at("files").at(12'345);
+        const Bencode& expected_file =
+            expected.at("info").at("files").at(12'345);
+        EXPECT_EQ(file.source_range()->begin,
+                  expected_file.source_range()->begin);
+        EXPECT_EQ(output.at("info").source_range()->end,
+                  expected.at("info").source_range()->end);
+    }
+}
+
+TEST(BencodeTest, parseParallelTopLevelList) {
+    std::string input = "l";
+    for (int i = 0; i < 20'000; i++)
+        input += std::format("d2:idi{}e4:name3:fooe", i);
+    input += "e";
+    EXPECT_EQ(Bencode::ParseParallel(input, 4),
+              Bencode::Parse(std::string_view(input)));
+}
+
+TEST(BencodeTest, parseParallelSmallInput) {
+    std::string_view input = "d3:bari2e3:fooli1eee";
+    EXPECT_EQ(Bencode::ParseParallel(input, 4), Bencode::Parse(input));
+}
+
+TEST(BencodeTest, parseParallelErrorsMatchParse) {
+    std::string valid = parallel_torrent_input();
+    std::string entries = "";
+    for (int i = 0; i < 10'000; i++)
+        entries += "d1:ai1e1:bi2ee";
+    std::string list = "l" + entries + "e";
+    std::vector<std::pair<std::string, std::size_t>> input_list {
+        {valid.substr(0, valid.size() - 1), Bencode::kDefaultMaxDepth},
+        {valid + "i1e", Bencode::kDefaultMaxDepth},
+        {valid, 3},
+        {"l" + entries + "d1:bi1e1:ai2ee" + entries + "e",
+         Bencode::kDefaultMaxDepth},
+        {"l" + entries + "d1:ai1e1:ai2ee" + entries + "e",
+         Bencode::kDefaultMaxDepth},
+        {"l" + entries + "i-0e" + entries + "e", Bencode::kDefaultMaxDepth},
+        {"d3:foo" + list + "3:bari1ee", Bencode::kDefaultMaxDepth},
+        {"d3:foo" + list + "li1ee3:bari1ee", Bencode::kDefaultMaxDepth},
+        {"d3:foo" + list + "3:zooe", Bencode::kDefaultMaxDepth}
+    };
+    for (const auto& [input, max_depth] : input_list) {
+        Bencode::ParseError::ExceptionID expected_id;
+        try {
+            Bencode::Parse(std::string_view(input), max_depth);
+            FAIL() << "Expected Bencode::ParseError";
+        }
+        catch (const Bencode::ParseError& e) {
+            expected_id = e.id_;
+        }
+        try {
+            Bencode::ParseParallel(input, 4, max_depth);
+            FAIL() << "Expected Bencode::ParseError";
+        }
+        catch (const Bencode::ParseError& e) {
+            EXPECT_EQ(e.id_, expected_id);
+        }
+    }
+}
+
+// Events
+
+class RecordingHandler : public Bencode::EventHandler {
+public:
+    void on_string(std::string_view value) override {
+        trace += std::format("s:{} ", value);
+    }
+    void on_integer(long value) override { trace += std::format("i:{} ", value); }
+    void begin_list() override { trace += "[ "; }
+    void end_list() override { trace += "] "; }
+    void begin_dict() override { trace += "{ "; }
+    void key(std::string_view key) override {
+        trace += std::format("k:{} ", key);
+    }
+    void end_dict() override { trace += "} "; }
+    std::string trace;
+};
+
+TEST(BencodeTest, parseEventsEmptyInput) {
+    RecordingHandler handler;
+    Bencode::ParseEvents("", handler);
+    EXPECT_EQ(handler.trace, "");
+}
+
+TEST(BencodeTest, parseEventsScalars) {
+    RecordingHandler handler;
+    Bencode::ParseEvents("11:Hello world", handler);
+    EXPECT_EQ(handler.trace, "s:Hello world ");
+    handler.trace.clear();
+    Bencode::ParseEvents("i-89e", handler);
+    EXPECT_EQ(handler.trace, "i:-89 ");
+}
+
+TEST(BencodeTest, parseEventsNested) {
+    RecordingHandler handler;
+    Bencode::ParseEvents("d3:barli1e0:e3:food1:ai2eee", handler);
+    EXPECT_EQ(handler.trace, "{ k:bar [ i:1 s: ] k:foo { k:a i:2 } } ");
+}
+
+TEST(BencodeTest, parseEventsStringsPointIntoInput) {
+    std::string input = "d3:foo3:bare";
+    class : public Bencode::EventHandler {
+    public:
+        void on_string(std::string_view value) override { data = value.data(); }
+        const char *data = nullptr;
+    } handler;
+    Bencode::ParseEvents(input, handler);
+    EXPECT_EQ(handler.data, input.data() + 8);
+}
+
+TEST(BencodeTest, parseEventsErrorsMatchParse) {
+    for_each_malformed_input([](const std::string& input,
+                                Bencode::ParseError::ExceptionID id) {
+        Bencode::EventHandler handler;
+        expect_parse_error(id, [&]() { Bencode::ParseEvents(input, handler); });
+    });
+}
+
+TEST(BencodeTest, parseEventsNestingTooDeep) {
+    RecordingHandler handler;
+    Bencode::ParseEvents("lld1:aleeee", handler, 4);
+    EXPECT_EQ(handler.trace, "[ [ { k:a [ ] } ] ] ");
+    EXPECT_THROW({Bencode::ParseEvents("lld1:aleeee", handler, 3);},
+                 Bencode::ParseError);
+}
+
+TEST(BencodeTest, parseEventsNestingHostileInput) {
+    std::vector<std::string> input_list {std::string(10'000'000, 'l'), ""};
+    for (int i = 0; i < 1'000'000; i++)
+        input_list.back() += "d1:a";
+    for (const std::string& input : input_list) {
+        Bencode::EventHandler handler;
+        try {
+            Bencode::ParseEvents(input, handler);
+            FAIL() << "Expected Bencode::ParseError";
+        }
+        catch (const Bencode::ParseError& e) {
+            EXPECT_EQ(e.id_, Bencode::ParseError::ExceptionID::kNestingTooDeep);
+        }
+    }
+}
+
+// Validation
+
+TEST(BencodeTest, validateAcceptsValidInput) {
+    std::vector<std::string> input_list {
+        "", "0:", "11:Hello world", "i-89e", "le", "de", "llei-89e3:bare",
+        "d3:bari2e3:foo5:hello4:listld0:0:eee"
+    };
+    for (const std::string& input : input_list)
+        EXPECT_TRUE(Bencode::Validate(input).has_value()) << input;
+}
+
+TEST(BencodeTest, validateErrorsMatchParse) {
+    for_each_malformed_input([](const std::string& input,
+                                Bencode::ParseError::ExceptionID id) {
+        auto result = Bencode::Validate(input);
+        ASSERT_FALSE(result.has_value());
+        EXPECT_EQ(result.error().id, id);
+    });
+}
+
+TEST(BencodeTest, validateReportsOffset) {
+    auto trailing = Bencode::Validate("i1ei2e");
+    ASSERT_FALSE(trailing.has_value());
+    EXPECT_EQ(trailing.error().id, Bencode::ParseError::ExceptionID::kTooMuchData);
+    EXPECT_EQ(trailing.error().offset, 3);
+
+    auto prefix = Bencode::Validate("l3:fooxe");
+    ASSERT_FALSE(prefix.has_value());
+    EXPECT_EQ(prefix.error().id, Bencode::ParseError::ExceptionID::kBadPrefix);
+    EXPECT_EQ(prefix.error().offset, 6);
+
+    // Ordering errors are found at the postfix of the dictionary
+    auto order = Bencode::Validate("ld3:fooi1e3:bari2eee");
+    ASSERT_FALSE(order.has_value());
+    EXPECT_EQ(order.error().id, Bencode::ParseError::ExceptionID::kDictBadOrder);
+    EXPECT_EQ(order.error().offset, 18);
+}
+
+TEST(BencodeTest, validateNestingTooDeep) {
+    auto result = Bencode::Validate("llleee", 2);
+    ASSERT_FALSE(result.has_value());
+    EXPECT_EQ(result.error().id,
+              Bencode::ParseError::ExceptionID::kNestingTooDeep);
+    EXPECT_TRUE(Bencode::Validate("llleee", 3).has_value());
+}
+
+// Non-throwing parse
+
+TEST(BencodeTest, tryParseMatchesParse) {
+    std::vector<std::string> input_list {
+        "", "0:", "11:Hello world", "i-89e", "le", "de", "llei-89e3:bare",
+        "d3:bari2e3:foo5:hello4:listld0:0:eee"
+    };
+    for (const std::string& input : input_list) {
+        std::expected<Bencode, Bencode::ParseFailure> output =
+            Bencode::TryParse(input);
+        ASSERT_TRUE(output.has_value()) << input;
+        EXPECT_EQ(*output, Bencode::Parse(input)) << input;
+    }
+}
+
+TEST(BencodeTest, tryParseErrorsMatchParse) {
+    for_each_malformed_input([](const std::string& input,
+                                Bencode::ParseError::ExceptionID id) {
+        auto output = Bencode::TryParse(input);
+        ASSERT_FALSE(output.has_value());
+        EXPECT_EQ(output.error().id, id);
+        EXPECT_EQ(output.error(), Bencode::Validate(input).error());
+    });
+}
+
+TEST(BencodeTest, tryParseNestingTooDeep) {
+    auto output = Bencode::TryParse("llleee", 2);
+    ASSERT_FALSE(output.has_value());
+    EXPECT_EQ(output.error().id,
+              Bencode::ParseError::ExceptionID::kNestingTooDeep);
+    EXPECT_EQ(output.error().offset, 2);
+}
+
+TEST(BencodeTest, tryParseWithResource) {
+    CountingResource resource;
+    {
+        auto output = Bencode::TryParse("ld3:fooi1eee", resource);
+        ASSERT_TRUE(output.has_value());
+        EXPECT_GT(resource.allocations, 0);
+        auto failed = Bencode::TryParse("ld3:fooi1ee", resource);
+        ASSERT_FALSE(failed.has_value());
+    }
+    EXPECT_EQ(resource.allocations, resource.deallocations);
+}
+
 // Dump
 
 void check_dump_exception(Bencode& data,
@@ -859,3 +1598,56 @@ TEST(BencodeTest, dumpToStream) {
     output << data;
     EXPECT_EQ(output.str(), "d3:barle3:fooi-89e5:hellodee");
 }
+
+TEST(BencodeTest, dumpToStringAppends) {
+    Bencode data {"foo", Bencode::List {-89, "bar"}};
+    std::string output = "prefix";
+    data.DumpTo(output);
+    EXPECT_EQ(output, "prefixd3:fooli-89e3:baree");
+}
+
+TEST(BencodeTest, dumpToOstream) {
+    Bencode data {"foo", Bencode::List {-89, "bar"}};
+    std::ostringstream output;
+    data.DumpTo(output);
+    EXPECT_EQ(output.str(), "d3:fooli-89e3:baree");
+}
+
+TEST(BencodeTest, dumpToOutputIterator) {
+    Bencode data {"foo", Bencode::List {-89, "bar"}};
+    std::vector<char> output;
+    data.DumpTo(std::back_inserter(output));
+    EXPECT_EQ(std::string(output.begin(), output.end()),
+              "d3:fooli-89e3:baree");
+}
+
+TEST(BencodeTest, dumpToFixedBuffer) {
+    Bencode data = Bencode::List {9223372036854775807l, "", Bencode::Dict {}};
+    char output[64] {};
+    char *end = data.DumpTo(output);
+    EXPECT_EQ(std::string_view(output, end), "li9223372036854775807e0:dee");
+}
+
+TEST(BencodeTest, dumpToNull) {
+    Bencode data = Bencode::List {1, {}};
+    std::string output;
+    EXPECT_THROW({data.DumpTo(output);}, Bencode::DumpError);
+    std::ostringstream stream;
+    EXPECT_THROW({data.DumpTo(stream);}, Bencode::DumpError);
+}
+
+TEST(BencodeTest, encodedSizeMatchesDump) {
+    std::vector<Bencode> data_list {
+        "", "Hello world", std::string(1234, 'a'), 0l, 9, 10, -1, -10,
+        9223372036854775807l, -9223372036854775807l - 1,
+        Bencode::List {}, Bencode::Dict {},
+        Bencode {"foo", Bencode::List {-89, "bar"}, "", Bencode::Dict {}}
+    };
+    for (const Bencode& data : data_list)
+        EXPECT_EQ(data.EncodedSize(), data.Dump().size()) << data;
+}
+
+TEST(BencodeTest, encodedSizeNull) {
+    Bencode data = Bencode::List {1, {}};
+    EXPECT_THROW({data.EncodedSize();}, Bencode::DumpError);
+}
@@ -0,0 +1,132 @@
+#include <gtest/gtest.h>
+#include "../src/bencode_index.h"
+
+#include <string>
+#include <vector>
+
+#include "malformed_inputs.h"
+
+//
+// Building
+//
+
+TEST(BencodeIndexTest, buildEmptyInput) {
+    BencodeIndex dut = BencodeIndex::Build("");
+    EXPECT_TRUE(dut.empty());
+    EXPECT_EQ(dut.Materialize().Type(), Bencode::ValueType::kNull);
+}
+
+TEST(BencodeIndexTest, buildTokens) {
+    std::string_view input = "d3:barli1e0:e3:fooi-2ee";
+    BencodeIndex dut = BencodeIndex::Build(input);
+    ASSERT_EQ(dut.size(), 7);
+
+    EXPECT_EQ(dut.Type(0), Bencode::ValueType::kDictionary);
+    EXPECT_EQ(dut[0].begin, 0);
+    EXPECT_EQ(dut[0].end, input.size());
+    EXPECT_EQ(dut[0].next, 7);
+    EXPECT_EQ(dut.size(0), 2);
+
+    EXPECT_EQ(dut.get_string(1), "bar");
+    EXPECT_EQ(dut.Type(2), Bencode::ValueType::kList);
+    EXPECT_EQ(dut.raw(2), "li1e0:e");
+    EXPECT_EQ(dut[2].next, 5);
+    EXPECT_EQ(dut.size(2), 2);
+    EXPECT_EQ(dut.Type(3), Bencode::ValueType::kInteger);
+    EXPECT_EQ(dut.get_int(3), 1l);
+    EXPECT_EQ(dut.Type(4), Bencode::ValueType::kString);
+    EXPECT_EQ(dut.get_string(4), "");
+    EXPECT_EQ(dut.get_string(5), "foo");
+    EXPECT_EQ(dut.get_int(6), -2l);
+}
+
+TEST(BencodeIndexTest, materializeMatchesParse) {
+    std::vector<std::string> input_list {
+        "0:", "3:foo", "i0e", "i-9223372036854775808e", "le", "de",
+        "llei-89e3:bare", "d3:bari2e3:foo5:hello4:listld0:0:eee",
+        "d0:i1e1:ai2ee", "d4:infod5:filesld6:lengthi3e4:pathl1:aeeeee"
+    };
+    for (const std::string& input : input_list) {
+        BencodeIndex dut = BencodeIndex::Build(input);
+        EXPECT_EQ(dut.Materialize(), Bencode::Parse(std::string_view(input)))
+            << input;
+    }
+}
+
+TEST(BencodeIndexTest, errorsMatchParse) {
+    for_each_malformed_input([](const std::string& input,
+                                Bencode::ParseError::ExceptionID id) {
+        expect_parse_error(id, [&]() { BencodeIndex::Build(input); });
+    });
+}
+
+TEST(BencodeIndexTest, buildNestingTooDeep) {
+    std::string input = std::string(4, 'l') + std::string(4, 'e');
+    EXPECT_NO_THROW({BencodeIndex::Build(input, 4);});
+    try {
+        BencodeIndex::Build(input, 3);
+        FAIL() << "Expected Bencode::ParseError";
+    }
+    catch (const Bencode::ParseError& e) {
+        EXPECT_EQ(e.id_, Bencode::ParseError::ExceptionID::kNestingTooDeep);
+    }
+}
+
+TEST(BencodeIndexTest, buildNestingHostileInput) {
+    try {
+        BencodeIndex::Build(std::string(10'000'000, 'l'));
+        FAIL() << "Expected Bencode::ParseError";
+    }
+    catch (const Bencode::ParseError& e) {
+        EXPECT_EQ(e.id_, Bencode::ParseError::ExceptionID::kNestingTooDeep);
+    }
+}
+
+TEST(BencodeIndexTest, materializeNestingBeyondDefaultLimit) {
+    std::size_t depth = 10'000;
+    std::string input = std::string(depth, 'l') + "i7e"
+        + std::string(depth, 'e');
+    BencodeIndex dut = BencodeIndex::Build(input, depth);
+    Bencode output = dut.Materialize();
+    const Bencode *elem = &output;
+    for (std::size_t i = 0; i < depth; i++)
+        elem = &elem->at(0);
+    EXPECT_EQ(elem->get_int(), 7l);
+}
+
+//
+// Navigation
+//
+
+TEST(BencodeIndexTest, findSkipsSubtrees) {
+    std::string_view input = "d5:filesll1:aeli1eee4:name3:foo6:pieces2:abe";
+    BencodeIndex dut = BencodeIndex::Build(input);
+    std::size_t pieces = dut.find(0, "pieces");
+    EXPECT_EQ(dut.get_string(pieces), "ab");
+    EXPECT_EQ(dut.get_string(dut.find(0, "name")), "foo");
+    EXPECT_EQ(dut.find(0, "length"), BencodeIndex::npos);
+    EXPECT_EQ(dut.find(0, "zzz"), BencodeIndex::npos);
+}
+
+TEST(BencodeIndexTest, listElementAt) {
+    BencodeIndex dut = BencodeIndex::Build("ll1:aeli1eei2ee");
+    EXPECT_EQ(dut.raw(dut.at(0, 0)), "l1:ae");
+    EXPECT_EQ(dut.raw(dut.at(0, 1)), "li1ee");
+    EXPECT_EQ(dut.get_int(dut.at(0, 2)), 2l);
+    EXPECT_THROW({dut.at(0, 3);}, std::out_of_range);
+}
+
+TEST(BencodeIndexTest, materializeSubtree) {
+    BencodeIndex dut = BencodeIndex::Build("d3:bard1:ali1ei2eee3:fooi1ee");
+    Bencode output = dut.Materialize(dut.find(0, "bar"));
+    EXPECT_EQ(output, Bencode({"a", Bencode {1l, 2l}}));
+}
+
+TEST(BencodeIndexTest, accessWrongType) {
+    BencodeIndex dut = BencodeIndex::Build("li1e3:fooe");
+    EXPECT_THROW({dut.get_string(1);}, std::bad_variant_access);
+    EXPECT_THROW({dut.get_int(2);}, std::bad_variant_access);
+    EXPECT_THROW({dut.find(0, "foo");}, std::bad_variant_access);
+    EXPECT_THROW({dut.at(1, 0);}, std::bad_variant_access);
+    EXPECT_THROW({dut[3];}, std::out_of_range);
+}
@@ -0,0 +1,206 @@
+#include <gtest/gtest.h>
+#include "../src/bencode_lazy_view.h"
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "malformed_inputs.h"
+
+//
+// Parsing
+//
+
+TEST(BencodeLazyViewTest, parseEmptyInput) {
+    BencodeLazyView output = BencodeLazyView::Parse("");
+    EXPECT_EQ(output.Type(), Bencode::ValueType::kNull);
+    EXPECT_TRUE(output.empty());
+}
+
+TEST(BencodeLazyViewTest, parseScalars) {
+    EXPECT_EQ(BencodeLazyView::Parse("11:Hello world").get_string(),
+              "Hello world");
+    EXPECT_EQ(BencodeLazyView::Parse("i-89e").get_int(), -89l);
+}
+
+TEST(BencodeLazyViewTest, parseDict) {
+    std::string input = "d3:bari2e3:foo5:hello4:listli1eee";
+    BencodeLazyView output = BencodeLazyView::Parse(input);
+    EXPECT_EQ(output.size(), 3);
+    EXPECT_EQ(output.at("bar").get_int(), 2l);
+    EXPECT_EQ(output.at("foo").get_string().data(), input.data() + 16);
+    EXPECT_EQ(output.at("list").at(0).get_int(), 1l);
+    EXPECT_EQ(output.at("list").raw(), "li1ee");
+    EXPECT_TRUE(output.contains("foo"));
+    EXPECT_FALSE(output.contains("baz"));
+    EXPECT_THROW({output.at("baz");}, std::out_of_range);
+}
+
+TEST(BencodeLazyViewTest, materializeMatchesParse) {
+    std::vector<std::string> input_list {
+        "0:", "3:foo", "i0e", "le", "de", "llei-89e3:bare",
+        "d3:bari2e3:foo5:hello4:listld0:0:eee", "d0:i1e1:ai2ee"
+    };
+    for (const std::string& input : input_list) {
+        BencodeLazyView dut = BencodeLazyView::Parse(input);
+        EXPECT_EQ(dut.raw(), input);
+        EXPECT_EQ(dut.Materialize(), Bencode::Parse(std::string_view(input)))
+            << input;
+    }
+}
+
+TEST(BencodeLazyViewTest, topLevelErrorsMatchBencode) {
+    for_each_malformed_input([](const std::string& input,
+                                Bencode::ParseError::ExceptionID id) {
+        expect_parse_error(id, [&]() { BencodeLazyView::Parse(input); });
+    });
+}
+
+TEST(BencodeLazyViewTest, topLevelTrailingDataMatchesBencode) {
+    std::vector<std::string> input_list {"e", "li1eli2e", "leli1ee"};
+    for (const std::string& input : input_list) {
+        SCOPED_TRACE(input);
+        try {
+            Bencode::Parse(std::string_view(input));
+            FAIL() << "Expected Bencode::ParseError";
+        }
+        catch (const Bencode::ParseError& e) {
+            expect_parse_error(e.id_, [&]() { BencodeLazyView::Parse(input); });
+        }
+    }
+}
+
+TEST(BencodeLazyViewTest, parseNestingTooDeep) {
+    std::string input = std::string(4, 'l') + std::string(4, 'e');
+    EXPECT_EQ(BencodeLazyView::Parse(input, 4).at(0).at(0).at(0).size(), 0);
+    using ID = Bencode::ParseError::ExceptionID;
+    expect_parse_error(ID::kNestingTooDeep,
+                       [&]() { BencodeLazyView::Parse(input, 3); });
+    expect_parse_error(ID::kNestingTooDeep,
+                       [&]() { BencodeLazyView::Parse("le", 0); });
+    EXPECT_EQ(BencodeLazyView::Parse("i1e", 0).get_int(), 1l);
+}
+
+TEST(BencodeLazyViewTest, parseNestingHostileInput) {
+    using ID = Bencode::ParseError::ExceptionID;
+    expect_parse_error(ID::kNestingTooDeep, []() {
+        BencodeLazyView::Parse(std::string(10'000'000, 'l'));
+    });
+    std::string input;
+    for (int i = 0; i < 1'000'000; i++)
+        input += "d1:a";
+    expect_parse_error(ID::kNestingTooDeep,
+                       [&]() { BencodeLazyView::Parse(input); });
+}
+
+//
+// Laziness
+//
+
+TEST(BencodeLazyViewTest, nestedErrorsReportedOnAccess) {
+    // The nested dictionary is well formed but its keys are out of order
+    BencodeLazyView dut = BencodeLazyView::Parse(
+        "d3:bard3:fooi1e3:bari2ee3:fooi1ee");
+    EXPECT_EQ(dut.at("foo").get_int(), 1l);
+    try {
+        dut.at("bar").size();
+        FAIL() << "Expected Bencode::ParseError";
+    }
+    catch (const Bencode::ParseError& e) {
+        EXPECT_EQ(e.id_, Bencode::ParseError::ExceptionID::kDictBadOrder);
+    }
+}
+
+TEST(BencodeLazyViewTest, structureOfSkippedSubtreesIsChecked) {
+    std::vector<std::string> input_list {"lli1eeli1e", "ll2:fooee", "lldaeee"};
+    for (const std::string& input : input_list)
+        EXPECT_THROW({BencodeLazyView::Parse(input);}, Bencode::ParseError)
+            << input;
+}
+
+TEST(BencodeLazyViewTest, keysOfSkippedSubtreesAreChecked) {
+    using ID = Bencode::ParseError::ExceptionID;
+    std::vector<std::pair<std::string, ID>> input_list {
+        {"lldi1e1:aeee", ID::kDictKeyNotString},
+        {"llddeeee", ID::kDictKeyNotString},
+        {"lld1:aeee", ID::kDictIncompletePair},
+        {"lld1:ali1ee1:beee", ID::kDictIncompletePair},
+        {"lld1:ad1:bi1e1:ceeee", ID::kDictIncompletePair},
+        {"lld1:axeee", ID::kBadPrefix}
+    };
+    for (const auto& [input, expected_id] : input_list) {
+        try {
+            BencodeLazyView::Parse(input);
+            FAIL() << "Expected Bencode::ParseError for " << input;
+        }
+        catch (const Bencode::ParseError& e) {
+            EXPECT_EQ(e.id_, expected_id) << input;
+        }
+    }
+
+    // Deeper than the bits kept inline
+    std::string deep;
+    for (int i = 0; i < 100; i++)
+        deep += "d1:al";
+    std::string closing(200, 'e');
+    EXPECT_NO_THROW({BencodeLazyView::Parse("l" + deep + closing + "e");});
+    EXPECT_THROW({BencodeLazyView::Parse("l" + deep + "di1e1:ae"
+                                         + closing + "e");},
+                 Bencode::ParseError);
+}
+
+//
+// Access
+//
+
+TEST(BencodeLazyViewTest, iterateOverList) {
+    BencodeLazyView dut = BencodeLazyView::Parse("li0ei1ei2ee");
+    long i = 0;
+    for (const BencodeLazyView& elem : dut) {
+        EXPECT_EQ(elem.get_int(), i);
+        i++;
+    }
+    EXPECT_EQ(i, dut.size());
+}
+
+TEST(BencodeLazyViewTest, itemIterationOverDict) {
+    BencodeLazyView dut = BencodeLazyView::Parse("d3:bari0e3:fooi1ee");
+    std::vector<std::string_view> key_list {"bar", "foo"};
+    long i = 0;
+    for (const auto& [key, value] : dut.items()) {
+        EXPECT_EQ(key, key_list[i]);
+        EXPECT_EQ(value.get_int(), i);
+        i++;
+    }
+    EXPECT_EQ(i, dut.size());
+}
+
+TEST(BencodeLazyViewTest, badAccess) {
+    BencodeLazyView dut = BencodeLazyView::Parse("i1e");
+    EXPECT_THROW({dut.get_string();}, std::bad_variant_access);
+    EXPECT_THROW({dut.at(0);}, std::bad_variant_access);
+    EXPECT_THROW({dut.at("foo");}, std::bad_variant_access);
+    EXPECT_THROW({dut.begin();}, std::bad_variant_access);
+    EXPECT_THROW({dut.items();}, std::bad_variant_access);
+    EXPECT_FALSE(dut.contains("foo"));
+}
+
+TEST(BencodeLazyViewTest, constAccessFromSeveralThreads) {
+    std::string input = "l";
+    for (int i = 0; i < 1000; i++)
+        input += "d1:ali" + std::to_string(i) + "eee";
+    input += "e";
+    const BencodeLazyView dut = BencodeLazyView::Parse(input);
+    std::vector<long> sums(4);
+    {
+        std::vector<std::jthread> readers {};
+        for (long& sum : sums) {
+            readers.emplace_back([&dut, &sum]() {
+                for (const BencodeLazyView& elem : dut)
+                    sum += elem.at("a").at(0).get_int();
+            });
+        }
+    }
+    for (long sum : sums)
+        EXPECT_EQ(sum, 999l * 1000 / 2);
+}
@@ -0,0 +1,115 @@
+#include <gtest/gtest.h>
+#include "../src/bencode_literal.h"
+
+#include <climits>
+#include <limits>
+#include <string>
+
+//
+// Encoding
+//
+
+TEST(BencodeLiteralTest, encodeScalars) {
+    constexpr auto string = BencodeEncode([] {
+        return BencodeConst {"Hello world"};
+    });
+    static_assert(string.view() == "l11:Hello worlde");
+    constexpr auto integer = BencodeEncode([] {
+        return BencodeConst(-89l);
+    });
+    static_assert(integer.view() == "i-89e");
+    constexpr auto empty = BencodeEncode([] {
+        return BencodeConst("");
+    });
+    EXPECT_EQ(empty.view(), "0:");
+    constexpr auto min = BencodeEncode([] {
+        return BencodeConst(LONG_MIN);
+    });
+    EXPECT_EQ(min.view(), Bencode(LONG_MIN).Dump());
+}
+
+TEST(BencodeLiteralTest, encodeMatchesDump) {
+    constexpr auto handshake = BencodeEncode([] {
+        return BencodeConst {
+            "v", "ftor 0.1",
+            "m", BencodeConst {"ut_pex", 2l, "ut_metadata", 1l},
+            "reqq", 250l,
+            "p", BencodeConst::List {}
+        };
+    });
+    Bencode expected {
+        "v", "ftor 0.1",
+        "m", Bencode {"ut_pex", 2l, "ut_metadata", 1l},
+        "reqq", 250l,
+        "p", Bencode::List {}
+    };
+    EXPECT_EQ(handshake.view(), expected.Dump());
+    EXPECT_EQ(handshake.view(),
+              "d1:md11:ut_metadatai1e6:ut_pexi2ee1:ple4:reqqi250e1:v8:ftor 0.1e");
+}
+
+TEST(BencodeLiteralTest, encodeList) {
+    constexpr auto list = BencodeEncode([] {
+        return BencodeConst {"foo", 1l, BencodeConst::List {"bar", "baz"}};
+    });
+    static_assert(list.view() == "l3:fooi1el3:bar3:bazee");
+}
+
+TEST(BencodeLiteralTest, duplicateKeyKeepsLastValue) {
+    constexpr auto dict = BencodeEncode([] {
+        return BencodeConst {"b", 1l, "a", 2l, "b", 3l};
+    });
+    static_assert(dict.view() == "d1:ai2e1:bi3ee");
+}
+
+//
+// Slots
+//
+
+TEST(BencodeLiteralTest, dumpFillsSlots) {
+    constexpr auto message = BencodeEncode([] {
+        return BencodeConst {
+            "peers", BencodeSlot {},
+            "interval", BencodeSlot {},
+            "complete", 0l
+        };
+    });
+    static_assert(message.slots.size() == 2);
+    Bencode peers = Bencode::List {Bencode {"ip", "10.0.0.1", "port", 6881l}};
+    std::string expected = Bencode {
+        "peers", peers, "interval", 1800l, "complete", 0l
+    }.Dump();
+    // Slots follow key order: interval, then peers
+    EXPECT_EQ(message.Dump(1800l, peers), expected);
+}
+
+TEST(BencodeLiteralTest, dumpToAppends) {
+    constexpr auto message = BencodeEncode([] {
+        return BencodeConst::List {BencodeSlot {}, "x", BencodeSlot {}};
+    });
+    std::string output = "prefix";
+    std::string name = "name";
+    message.DumpTo(output, name, -5l);
+    EXPECT_EQ(output, "prefixl4:name1:xi-5ee");
+    message.DumpTo(output, "", 0l);
+    EXPECT_EQ(output, "prefixl4:name1:xi-5eel0:1:xi0ee");
+}
+
+template <class Literal, class Arg>
+concept DumpsWith = requires (const Literal& literal, const Arg& arg) {
+    literal.Dump(arg);
+};
+
+TEST(BencodeLiteralTest, slotsTakeLongIntegers) {
+    constexpr auto message = BencodeEncode([] {
+        return BencodeConst::List {BencodeSlot {}};
+    });
+    EXPECT_EQ(message.Dump(std::numeric_limits<long>::min()),
+              "li-9223372036854775808ee");
+    using Literal = decltype(message);
+    static_assert(DumpsWith<Literal, long>);
+    static_assert(!DumpsWith<Literal, int>);
+    static_assert(!DumpsWith<Literal, char>);
+    static_assert(!DumpsWith<Literal, bool>);
+    static_assert(!DumpsWith<Literal, unsigned long>);
+}
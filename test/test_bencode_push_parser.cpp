@@ -0,0 +1,117 @@
+#include <gtest/gtest.h>
+#include "../src/bencode_push_parser.h"
+
+#include <sstream>
+
+#include "malformed_inputs.h"
+
+Bencode push_parse_in_chunks(std::string_view input, std::size_t chunk_size) {
+    BencodePushParser dut;
+    while (!input.empty()) {
+        dut.Feed(input.substr(0, chunk_size));
+        input.remove_prefix(std::min(chunk_size, input.size()));
+    }
+    return dut.Finish();
+}
+
+TEST(BencodePushParserTest, finishWithoutInput) {
+    BencodePushParser dut;
+    EXPECT_EQ(dut.Finish().Type(), Bencode::ValueType::kNull);
+}
+
+TEST(BencodePushParserTest, needMoreUntilComplete) {
+    BencodePushParser dut;
+    EXPECT_EQ(dut.Feed("d3:fo"), BencodePushParser::Status::kNeedMore);
+    EXPECT_EQ(dut.Feed("o"), BencodePushParser::Status::kNeedMore);
+    EXPECT_EQ(dut.Feed("li-1"), BencodePushParser::Status::kNeedMore);
+    EXPECT_EQ(dut.Feed("2e11:Hello"), BencodePushParser::Status::kNeedMore);
+    EXPECT_EQ(dut.Feed(" worlde"), BencodePushParser::Status::kNeedMore);
+    EXPECT_EQ(dut.Feed("e"), BencodePushParser::Status::kComplete);
+    Bencode output = dut.Finish();
+    EXPECT_EQ(output, (Bencode {"foo", Bencode::List {-12, "Hello world"}}));
+}
+
+TEST(BencodePushParserTest, scalarCompletesWithoutFinish) {
+    BencodePushParser dut;
+    EXPECT_EQ(dut.Feed("i4"), BencodePushParser::Status::kNeedMore);
+    EXPECT_EQ(dut.Feed("2e"), BencodePushParser::Status::kComplete);
+    EXPECT_EQ(dut.Finish().get_int(), 42l);
+}
+
+TEST(BencodePushParserTest, matchesParseForEveryChunkSize) {
+    std::vector<std::string> input_list {
+        "0:", "3:foo", "i0e", "i-9223372036854775808e", "i9223372036854775807e",
+        "le", "de", "llei-89e3:bare", "d3:bari2e3:foo5:hello4:listld0:0:eee",
+        "d0:i1e1:ai2ee"
+    };
+    for (const std::string& input : input_list) {
+        std::istringstream stream(input);
+        Bencode expected = Bencode::Parse(stream);
+        for (std::size_t chunk_size = 1; chunk_size <= input.size();
+                chunk_size++)
+            EXPECT_EQ(push_parse_in_chunks(input, chunk_size), expected)
+                << input << " in chunks of " << chunk_size;
+    }
+}
+
+TEST(BencodePushParserTest, errorsMatchParse) {
+    for_each_malformed_input([](const std::string& input,
+                                Bencode::ParseError::ExceptionID id) {
+        for (std::size_t chunk_size = 1; chunk_size <= input.size();
+                chunk_size++) {
+            SCOPED_TRACE(chunk_size);
+            expect_parse_error(id,
+                [&]() { push_parse_in_chunks(input, chunk_size); });
+        }
+    });
+}
+
+TEST(BencodePushParserTest, nestingTooDeep) {
+    BencodePushParser dut(4);
+    dut.Feed("lld1:al");
+    EXPECT_EQ(dut.Feed("eeee"), BencodePushParser::Status::kComplete);
+    dut.Finish();
+    dut.Feed("lld1:a");
+    try {
+        dut.Feed("ll");
+        FAIL() << "Expected Bencode::ParseError";
+    }
+    catch (const Bencode::ParseError& e) {
+        EXPECT_EQ(e.id_, Bencode::ParseError::ExceptionID::kNestingTooDeep);
+    }
+}
+
+TEST(BencodePushParserTest, nestingHostileInput) {
+    BencodePushParser dut;
+    std::string chunk(4096, 'l');
+    try {
+        for (int i = 0; i < 2'500; i++)
+            dut.Feed(chunk);
+        FAIL() << "Expected Bencode::ParseError";
+    }
+    catch (const Bencode::ParseError& e) {
+        EXPECT_EQ(e.id_, Bencode::ParseError::ExceptionID::kNestingTooDeep);
+    }
+}
+
+TEST(BencodePushParserTest, dataAfterComplete) {
+    BencodePushParser dut;
+    EXPECT_EQ(dut.Feed("le"), BencodePushParser::Status::kComplete);
+    EXPECT_THROW({dut.Feed("i0e");}, Bencode::ParseError);
+}
+
+TEST(BencodePushParserTest, reuseAfterFinish) {
+    BencodePushParser dut;
+    dut.Feed("3:foo");
+    EXPECT_EQ(dut.Finish().get_string(), "foo");
+    dut.Feed("i1e");
+    EXPECT_EQ(dut.Finish().get_int(), 1l);
+}
+
+TEST(BencodePushParserTest, reuseAfterReset) {
+    BencodePushParser dut;
+    EXPECT_THROW({dut.Feed("l1a");}, Bencode::ParseError);
+    dut.Reset();
+    dut.Feed("l1:ae");
+    EXPECT_EQ(dut.Finish(), Bencode {"a"});
+}
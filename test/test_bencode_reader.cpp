@@ -0,0 +1,154 @@
+#include <gtest/gtest.h>
+#include "../src/bencode_reader.h"
+
+#include <optional>
+#include <string>
+#include <variant>
+#include <vector>
+
+//
+// Reading
+//
+
+TEST(BencodeReaderTest, readScalars) {
+    BencodeReader reader("11:Hello world");
+    EXPECT_EQ(reader.peek(), Bencode::ValueType::kString);
+    EXPECT_EQ(reader.read_string(), "Hello world");
+    EXPECT_EQ(reader.peek(), Bencode::ValueType::kNull);
+    EXPECT_NO_THROW(reader.finish());
+
+    BencodeReader integer("i-89e");
+    EXPECT_EQ(integer.peek(), Bencode::ValueType::kInteger);
+    EXPECT_EQ(integer.read_int(), -89l);
+}
+
+TEST(BencodeReaderTest, readDict) {
+    std::string input = "d3:bari2e3:fooli1e1:xee";
+    BencodeReader reader(input);
+    std::string_view key;
+    reader.begin_dict();
+    ASSERT_TRUE(reader.next_key(key));
+    EXPECT_EQ(key, "bar");
+    EXPECT_EQ(reader.read_int(), 2l);
+    ASSERT_TRUE(reader.next_key(key));
+    EXPECT_EQ(key, "foo");
+    std::size_t begin = reader.offset();
+    reader.begin_list();
+    ASSERT_TRUE(reader.next_element());
+    EXPECT_EQ(reader.read_int(), 1l);
+    ASSERT_TRUE(reader.next_element());
+    EXPECT_EQ(reader.read_string().data(), input.data() + 20);
+    EXPECT_FALSE(reader.next_element());
+    EXPECT_EQ(reader.consumed(begin), "li1e1:xe");
+    EXPECT_FALSE(reader.next_key(key));
+    EXPECT_NO_THROW(reader.finish());
+}
+
+TEST(BencodeReaderTest, readWrongType) {
+    BencodeReader reader("i1e");
+    EXPECT_THROW({reader.read_string();}, std::bad_variant_access);
+    EXPECT_THROW({reader.begin_list();}, std::bad_variant_access);
+    EXPECT_EQ(reader.read_int(), 1l);
+}
+
+//
+// Skipping
+//
+
+TEST(BencodeReaderTest, skipNested) {
+    BencodeReader reader("ld3:bari2e3:fooli1eld0:leeeeei5ee");
+    reader.begin_list();
+    ASSERT_TRUE(reader.next_element());
+    reader.skip();
+    ASSERT_TRUE(reader.next_element());
+    EXPECT_EQ(reader.read_int(), 5l);
+    EXPECT_FALSE(reader.next_element());
+    EXPECT_NO_THROW(reader.finish());
+}
+
+TEST(BencodeReaderTest, skipErrorsMatchParse) {
+    std::vector<std::string> input_list {
+        "x", "i1", "l", "li1e", "d3:foo", "d3:fooe", "d3:bari1e3:aari2ee",
+        "d3:fooi1e3:fooi2ee", "i1ei2e", "3:fo", "i-0e", "llllllllleeeeeeeee"
+    };
+    for (const std::string& input : input_list) {
+        SCOPED_TRACE(input);
+        std::optional<Bencode::ParseError::ExceptionID> expected;
+        try {
+            Bencode::Parse(input, 8);
+        } catch (const Bencode::ParseError& e) {
+            expected = e.id_;
+        }
+        ASSERT_TRUE(expected.has_value());
+
+        try {
+            BencodeReader reader(input, 8);
+            reader.skip();
+            reader.finish();
+            FAIL() << "expected ParseError";
+        } catch (const Bencode::ParseError& e) {
+            EXPECT_EQ(e.id_, *expected);
+        }
+    }
+}
+
+TEST(BencodeReaderTest, skipNestingHostileInput) {
+    std::string input(10'000'000, 'l');
+    BencodeReader reader(input);
+    try {
+        reader.skip();
+        FAIL() << "Expected Bencode::ParseError";
+    }
+    catch (const Bencode::ParseError& e) {
+        EXPECT_EQ(e.id_, Bencode::ParseError::ExceptionID::kNestingTooDeep);
+    }
+}
+
+TEST(BencodeReaderTest, tryFormsMatchValidate) {
+    std::vector<std::string> input_list {
+        "x", "i1", "l", "li1e", "d3:foo", "d3:fooe", "d3:bari1e3:aari2ee",
+        "d3:fooi1e3:fooi2ee", "i1ei2e", "3:fo", "i-0e", "llllllllleeeeeeeee"
+    };
+    for (const std::string& input : input_list) {
+        SCOPED_TRACE(input);
+        auto expected = Bencode::Validate(input, 8);
+        ASSERT_FALSE(expected.has_value());
+
+        BencodeReader reader(input, 8);
+        auto skipped = reader.try_skip();
+        auto failure = skipped ? reader.try_finish() : skipped;
+        ASSERT_FALSE(failure.has_value());
+        EXPECT_EQ(failure.error(), expected.error().id);
+        EXPECT_EQ(reader.offset(), expected.error().offset);
+    }
+}
+
+TEST(BencodeReaderTest, tryFormsRead) {
+    BencodeReader reader("d3:fooi7ee");
+    std::string_view key;
+    EXPECT_EQ(reader.try_peek(), Bencode::ValueType::kDictionary);
+    ASSERT_TRUE(reader.try_begin_dict().has_value());
+    EXPECT_EQ(reader.try_next_key(key), true);
+    EXPECT_EQ(key, "foo");
+    EXPECT_EQ(reader.try_read_int(), 7l);
+    EXPECT_EQ(reader.try_next_key(key), false);
+    EXPECT_TRUE(reader.try_finish().has_value());
+}
+
+TEST(BencodeReaderTest, stepOutsideContainer) {
+    auto trailing = std::unexpected(
+        Bencode::ParseError::ExceptionID::kTooMuchData);
+    std::string_view key;
+    for (std::string_view input : {"", "e", "i1e", "1:ae"}) {
+        SCOPED_TRACE(input);
+        BencodeReader reader(input);
+        EXPECT_EQ(reader.try_next_element(), trailing);
+        EXPECT_EQ(reader.try_next_key(key), trailing);
+        EXPECT_THROW({reader.next_element();}, Bencode::ParseError);
+    }
+
+    BencodeReader reader("lei1e");
+    reader.begin_list();
+    EXPECT_FALSE(reader.next_element());
+    EXPECT_EQ(reader.try_next_element(), trailing);
+}
@@ -0,0 +1,165 @@
+#include <gtest/gtest.h>
+#include "../src/bencode_schema.h"
+
+#include <exception>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <variant>
+#include <vector>
+
+namespace {
+
+class PeerError: public std::exception {
+public:
+    enum class ExceptionID {
+        kNotDict,
+        kMissingIP,
+        kIPNotString,
+        kMissingPort,
+        kPortNotInt,
+        kTagsNotList,
+        kTagNotString,
+        kPeersNotList,
+        kPeerNotDict
+    };
+    PeerError(ExceptionID id) : id_(id) {}
+    const ExceptionID id_;
+};
+using ID = PeerError::ExceptionID;
+
+struct Peer {
+    std::string ip;
+    long port;
+    std::optional<std::vector<std::string_view>> tags;
+    std::string_view encoding;
+};
+
+struct Swarm {
+    std::vector<Peer> peers;
+    std::optional<long> interval;
+};
+
+}
+
+template <>
+struct BencodeSchema<Peer> {
+    using Error = PeerError;
+    static constexpr std::tuple fields {
+        BencodeField<&Peer::ip>("ip", ID::kMissingIP, ID::kIPNotString),
+        BencodeField<&Peer::port>("port", ID::kMissingPort, ID::kPortNotInt),
+        BencodeField<&Peer::tags>("tags", ID::kNotDict, ID::kTagsNotList,
+                                  ID::kTagNotString)
+    };
+    static constexpr auto encoding = &Peer::encoding;
+};
+
+template <>
+struct BencodeSchema<Swarm> {
+    using Error = PeerError;
+    static constexpr std::tuple fields {
+        BencodeField<&Swarm::peers>("peers", ID::kNotDict, ID::kPeersNotList,
+                                    ID::kPeerNotDict),
+        BencodeField<&Swarm::interval>("interval", ID::kNotDict,
+                                       ID::kPortNotInt)
+    };
+};
+
+namespace {
+
+ID DecodeError(std::string_view input) {
+    try {
+        BencodeDecode<Swarm>(input, ID::kNotDict);
+    } catch (const PeerError& e) {
+        return e.id_;
+    }
+    ADD_FAILURE() << "expected PeerError for " << input;
+    return ID::kNotDict;
+}
+
+}
+
+//
+// Decoding
+//
+
+TEST(BencodeSchemaTest, decodeStruct) {
+    std::string input = "d2:ip9:127.0.0.14:porti6881e4:tagsl1:a1:bee";
+    Peer output = BencodeDecode<Peer>(input, ID::kNotDict);
+    EXPECT_EQ(output.ip, "127.0.0.1");
+    EXPECT_EQ(output.port, 6881l);
+    ASSERT_TRUE(output.tags.has_value());
+    EXPECT_EQ(*output.tags, (std::vector<std::string_view> {"a", "b"}));
+    EXPECT_EQ(output.tags->front().data(), input.data() + 37);
+    EXPECT_EQ(output.encoding, input);
+}
+
+TEST(BencodeSchemaTest, decodeNested) {
+    std::string input = "d8:intervali30e5:peersld2:ip1:a4:porti1eed"
+                        "5:extra0:2:ip1:b4:porti2eeee";
+    Swarm output = BencodeDecode<Swarm>(input, ID::kNotDict);
+    EXPECT_EQ(output.interval, 30l);
+    ASSERT_EQ(output.peers.size(), 2);
+    EXPECT_EQ(output.peers[0].ip, "a");
+    EXPECT_EQ(output.peers[1].port, 2l);
+    EXPECT_FALSE(output.peers[1].tags.has_value());
+    EXPECT_EQ(output.peers[0].encoding, "d2:ip1:a4:porti1ee");
+}
+
+TEST(BencodeSchemaTest, decodeOptionalMissing) {
+    Swarm output = BencodeDecode<Swarm>("d5:peerslee", ID::kNotDict);
+    EXPECT_TRUE(output.peers.empty());
+    EXPECT_FALSE(output.interval.has_value());
+}
+
+//
+// Errors
+//
+
+TEST(BencodeSchemaTest, schemaErrors) {
+    EXPECT_EQ(DecodeError("le"), ID::kNotDict);
+    EXPECT_EQ(DecodeError("d5:peersi1ee"), ID::kPeersNotList);
+    EXPECT_EQ(DecodeError("d5:peersli1eee"), ID::kPeerNotDict);
+    EXPECT_EQ(DecodeError("d5:peersld4:porti1eeee"), ID::kMissingIP);
+    EXPECT_EQ(DecodeError("d5:peersld2:ipi1e4:porti1eeee"),
+              ID::kIPNotString);
+    EXPECT_EQ(DecodeError("d5:peersld2:ip1:a4:porti1e4:tagsli1eeeee"),
+              ID::kTagNotString);
+}
+
+TEST(BencodeSchemaTest, firstSchemaErrorWins) {
+    EXPECT_EQ(DecodeError("d5:peersld2:ipi1eeee"), ID::kIPNotString);
+}
+
+TEST(BencodeSchemaTest, parseErrorBeatsSchemaError) {
+    std::vector<std::string> input_list {
+        "li1e", "d5:peersi1e", "d5:peersi1e3:aaa0:e", "d5:peersi1eei1e"
+    };
+    for (const std::string& input : input_list) {
+        SCOPED_TRACE(input);
+        EXPECT_THROW({BencodeDecode<Swarm>(input, ID::kNotDict);},
+                     Bencode::ParseError);
+    }
+}
+
+TEST(BencodeSchemaTest, tryDecodeSchemaError) {
+    auto output = BencodeTryDecode<Swarm>("d5:peersli1eee", ID::kNotDict);
+    ASSERT_FALSE(output.has_value());
+    ASSERT_TRUE(std::holds_alternative<ID>(output.error()));
+    EXPECT_EQ(std::get<ID>(output.error()), ID::kPeerNotDict);
+}
+
+TEST(BencodeSchemaTest, tryDecodeParseFailure) {
+    std::vector<std::string> input_list {
+        "li1e", "d5:peersi1e", "d5:peersi1e3:aaa0:e", "d5:peersi1eei1e"
+    };
+    for (const std::string& input : input_list) {
+        SCOPED_TRACE(input);
+        auto output = BencodeTryDecode<Swarm>(input, ID::kNotDict);
+        ASSERT_FALSE(output.has_value());
+        ASSERT_TRUE(std::holds_alternative<Bencode::ParseFailure>(
+            output.error()));
+        EXPECT_EQ(std::get<Bencode::ParseFailure>(output.error()),
+                  Bencode::Validate(input).error());
+    }
+}
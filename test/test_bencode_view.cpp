@@ -0,0 +1,163 @@
+#include <gtest/gtest.h>
+#include "../src/bencode_view.h"
+
+#include <sstream>
+
+#include "malformed_inputs.h"
+
+void check_view_parse_exception(std::string_view input,
+                                Bencode::ParseError::ExceptionID expected_id) {
+    try {
+        BencodeView::Parse(input);
+        FAIL() << "Expected Bencode::ParseError";
+    }
+    catch (const Bencode::ParseError& e) {
+        EXPECT_EQ(e.id_, expected_id);
+    }
+    catch (const std::exception& e) {
+        FAIL() << "Expected Bencode::ParseError, got: " << e.what();
+    }
+}
+
+//
+// Parsing
+//
+
+TEST(BencodeViewTest, parseEmptyInput) {
+    BencodeView output = BencodeView::Parse(std::string_view(""));
+    EXPECT_EQ(output.Type(), Bencode::ValueType::kNull);
+    EXPECT_TRUE(output.empty());
+}
+
+TEST(BencodeViewTest, parseString) {
+    BencodeView output = BencodeView::Parse(std::string_view("11:Hello world"));
+    EXPECT_EQ(output.Type(), Bencode::ValueType::kString);
+    EXPECT_EQ(output.get_string(), "Hello world");
+}
+
+TEST(BencodeViewTest, parseStringEmpty) {
+    BencodeView output = BencodeView::Parse(std::string_view("0:"));
+    EXPECT_EQ(output.get_string(), "");
+}
+
+TEST(BencodeViewTest, parseStringPointsIntoInput) {
+    std::string input = "l3:foo5:helloe";
+    BencodeView output = BencodeView::Parse(input);
+    EXPECT_EQ(output.at(0).get_string().data(), input.data() + 3);
+    EXPECT_EQ(output.at(1).get_string().data(), input.data() + 8);
+}
+
+TEST(BencodeViewTest, parseInteger) {
+    EXPECT_EQ(BencodeView::Parse(std::string_view("i43e")).get_int(), 43l);
+    EXPECT_EQ(BencodeView::Parse(std::string_view("i-89e")).get_int(), -89l);
+    EXPECT_EQ(BencodeView::Parse(std::string_view("i0e")).get_int(), 0l);
+}
+
+TEST(BencodeViewTest, parseList) {
+    BencodeView output = BencodeView::Parse(std::string_view("llei-89e3:bare"));
+    EXPECT_EQ(output.Type(), Bencode::ValueType::kList);
+    EXPECT_EQ(output.size(), 3);
+    EXPECT_EQ(output.at(0).Type(), Bencode::ValueType::kList);
+    EXPECT_TRUE(output.at(0).empty());
+    EXPECT_EQ(output.at(1).get_int(), -89l);
+    EXPECT_EQ(output.at(2).get_string(), "bar");
+}
+
+TEST(BencodeViewTest, parseDict) {
+    BencodeView output = BencodeView::Parse(
+        std::string_view("d3:bari2e3:foo5:hello4:listli1eee"));
+    EXPECT_EQ(output.Type(), Bencode::ValueType::kDictionary);
+    EXPECT_EQ(output.size(), 3);
+    EXPECT_EQ(output.at("bar").get_int(), 2l);
+    EXPECT_EQ(output.at("foo").get_string(), "hello");
+    EXPECT_EQ(output.at("list").at(0).get_int(), 1l);
+    EXPECT_TRUE(output.contains("foo"));
+    EXPECT_FALSE(output.contains("baz"));
+}
+
+TEST(BencodeViewTest, parseBytes) {
+    std::string input = "d3:foo3:bare";
+    std::span<const std::byte> bytes(
+        reinterpret_cast<const std::byte*>(input.data()), input.size());
+    BencodeView output = BencodeView::Parse(bytes);
+    EXPECT_EQ(output.at("foo").get_string(), "bar");
+}
+
+TEST(BencodeViewTest, parseErrorsMatchBencode) {
+    for_each_malformed_input(check_view_parse_exception);
+}
+
+TEST(BencodeViewTest, parseNestingTooDeep) {
+    std::string input = std::string(4, 'l') + std::string(4, 'e');
+    EXPECT_EQ(BencodeView::Parse(input, 4).at(0).at(0).at(0).size(), 0);
+    check_view_parse_exception(
+        std::string(Bencode::kDefaultMaxDepth + 1, 'l')
+            + std::string(Bencode::kDefaultMaxDepth + 1, 'e'),
+        Bencode::ParseError::ExceptionID::kNestingTooDeep);
+}
+
+TEST(BencodeViewTest, parseNestingHostileInput) {
+    check_view_parse_exception(std::string(10'000'000, 'l'),
+        Bencode::ParseError::ExceptionID::kNestingTooDeep);
+    check_view_parse_exception(std::string(10'000'000, 'd'),
+        Bencode::ParseError::ExceptionID::kDictKeyNotString);
+    std::string input;
+    for (int i = 0; i < 1'000'000; i++)
+        input += "d1:a";
+    check_view_parse_exception(input,
+        Bencode::ParseError::ExceptionID::kNestingTooDeep);
+}
+
+TEST(BencodeViewTest, parseDictKeyOrder) {
+    check_view_parse_exception("d1:bi1e1:ai2e1:ci3ee",
+        Bencode::ParseError::ExceptionID::kDictBadOrder);
+    check_view_parse_exception("d1:ai1e1:bi2e1:bi3ee",
+        Bencode::ParseError::ExceptionID::kDictDuplicateKeys);
+    BencodeView output = BencodeView::Parse(
+        std::string_view("d1:ai1e1:bi2e1:ci3ee"));
+    EXPECT_EQ(output.at("c").get_int(), 3l);
+}
+
+//
+// Access
+//
+
+TEST(BencodeViewTest, iterateOverList) {
+    BencodeView dut = BencodeView::Parse(std::string_view("li0ei1ei2ee"));
+    long i = 0;
+    for (const BencodeView& elem : dut) {
+        EXPECT_EQ(elem.get_int(), i);
+        i++;
+    }
+    EXPECT_EQ(i, dut.size());
+}
+
+TEST(BencodeViewTest, itemIterationOverDict) {
+    BencodeView dut = BencodeView::Parse(std::string_view("d3:bari0e3:fooi1ee"));
+    std::vector<std::string_view> key_list {"bar", "foo"};
+    long i = 0;
+    for (const auto& [key, value] : dut.items()) {
+        EXPECT_EQ(key, key_list[i]);
+        EXPECT_EQ(value.get_int(), i);
+        i++;
+    }
+    EXPECT_EQ(i, dut.size());
+}
+
+TEST(BencodeViewTest, badAccess) {
+    BencodeView dut = BencodeView::Parse(std::string_view("i1e"));
+    EXPECT_THROW({dut.get_string();}, std::bad_variant_access);
+    EXPECT_THROW({dut.at(0);}, std::bad_variant_access);
+    EXPECT_THROW({dut.at("foo");}, std::bad_variant_access);
+    EXPECT_THROW({dut.begin();}, std::bad_variant_access);
+    EXPECT_THROW({dut.items();}, std::bad_variant_access);
+    EXPECT_FALSE(dut.contains("foo"));
+}
+
+TEST(BencodeViewTest, equality) {
+    std::string first = "d3:fooli1e3:baree";
+    std::string second = first;
+    EXPECT_EQ(BencodeView::Parse(first), BencodeView::Parse(second));
+    EXPECT_FALSE(BencodeView::Parse(first) == BencodeView::Parse(
+        std::string_view("d3:fooli2e3:baree")));
+}
@@ -0,0 +1,280 @@
+#include <gtest/gtest.h>
+#include "../src/bencode_writer.h"
+
+#include <cstdio>
+#include <limits>
+#include <sstream>
+#include <string>
+
+#include <unistd.h>
+
+using WriteID = BencodeWriter::WriteError::ExceptionID;
+
+static void check_write_error(WriteID expected_id,
+                              void (*write)(BencodeWriter&)) {
+    std::string output;
+    BencodeWriter writer(output);
+    try {
+        write(writer);
+        FAIL() << "Expected BencodeWriter::WriteError";
+    }
+    catch (const BencodeWriter::WriteError& e) {
+        EXPECT_EQ(e.id_, expected_id);
+    }
+}
+
+//
+// Writing
+//
+
+TEST(BencodeWriterTest, writeScalars) {
+    std::string output;
+    BencodeWriter(output).value("Hello world");
+    EXPECT_EQ(output, "11:Hello world");
+
+    output.clear();
+    BencodeWriter(output).value(-89l);
+    EXPECT_EQ(output, "i-89e");
+}
+
+TEST(BencodeWriterTest, writeOtherIntegerTypes) {
+    std::string output;
+    BencodeWriter(output).value(0);
+    EXPECT_EQ(output, "i0e");
+
+    output.clear();
+    BencodeWriter(output).value(std::size_t {16384});
+    EXPECT_EQ(output, "i16384e");
+
+    output.clear();
+    BencodeWriter(output).value(static_cast<short>(-7));
+    EXPECT_EQ(output, "i-7e");
+
+    output.clear();
+    EXPECT_THROW({BencodeWriter(output).value(
+                     std::numeric_limits<unsigned long>::max());},
+                 std::out_of_range);
+    EXPECT_EQ(output, "");
+}
+
+TEST(BencodeWriterTest, writeMatchesDump) {
+    std::string output;
+    BencodeWriter writer(output);
+    writer.begin_dict();
+    writer.key("announce");
+    writer.value(std::string("http://tracker"));
+    writer.key("info");
+    writer.begin_dict();
+    writer.key("files");
+    writer.begin_list();
+    writer.value(Bencode {"length", 1l, "path", Bencode::List {"a"}});
+    writer.end_list();
+    writer.key("name");
+    writer.value(std::string_view("name"));
+    writer.key("piece length");
+    writer.value(16384l);
+    writer.end_dict();
+    writer.end_dict();
+    writer.finish();
+
+    Bencode expected {
+        "announce", "http://tracker",
+        "info", Bencode {
+            "files", Bencode::List {
+                Bencode {"length", 1l, "path", Bencode::List {"a"}}
+            },
+            "name", "name",
+            "piece length", 16384l
+        }
+    };
+    EXPECT_EQ(output, expected.Dump());
+}
+
+TEST(BencodeWriterTest, writeStringInParts) {
+    std::string output;
+    BencodeWriter writer(output);
+    writer.begin_string(6);
+    writer.append_string("foo");
+    writer.append_string("");
+    writer.append_string("bar");
+    writer.finish();
+    EXPECT_EQ(output, "6:foobar");
+}
+
+TEST(BencodeWriterTest, writeToStream) {
+    std::ostringstream output;
+    std::string large(100'000, 'a');
+    {
+        BencodeWriter writer(output);
+        writer.begin_list();
+        for (long i = 0; i < 10'000; i++)
+            writer.value(i);
+        writer.value(large);
+        writer.end_list();
+        writer.finish();
+    }
+    Bencode expected = Bencode::List {};
+    for (long i = 0; i < 10'000; i++)
+        expected.push_back(i);
+    expected.push_back(large);
+    EXPECT_EQ(output.str(), expected.Dump());
+}
+
+TEST(BencodeWriterTest, writeLargeNodeInChunks) {
+    std::ostringstream output;
+    Bencode files = Bencode::List {};
+    for (long i = 0; i < 20'000; i++)
+        files.push_back(Bencode {"length", i, "path", Bencode::List {"a"}});
+    std::string expected = Bencode {"files", files}.Dump();
+
+    BencodeWriter writer(output);
+    writer.begin_dict();
+    writer.key("files");
+    writer.value(files);
+    // Only the part since the last flush is still buffered
+    EXPECT_GT(output.str().size(), expected.size() - 64 * 1024);
+    writer.end_dict();
+    writer.finish();
+    EXPECT_EQ(output.str(), expected);
+}
+
+TEST(BencodeWriterTest, destructorDiscardsUnfinished) {
+    std::ostringstream output;
+    {
+        BencodeWriter writer(output);
+        writer.begin_list();
+        writer.value(1l);
+    }
+    EXPECT_EQ(output.str(), "");
+}
+
+TEST(BencodeWriterTest, destructorAfterFinish) {
+    std::ostringstream output;
+    {
+        BencodeWriter writer(output);
+        writer.begin_list();
+        writer.value(1l);
+        writer.end_list();
+        writer.finish();
+    }
+    EXPECT_EQ(output.str(), "li1ee");
+}
+
+TEST(BencodeWriterTest, writeToFileDescriptor) {
+    std::FILE *file = std::tmpfile();
+    ASSERT_NE(file, nullptr);
+    int fd = fileno(file);
+    {
+        BencodeWriter writer(fd);
+        writer.begin_dict();
+        writer.key("pieces");
+        writer.value(std::string(200'000, 'p'));
+        writer.end_dict();
+        writer.finish();
+    }
+    std::string expected = Bencode {
+        "pieces", std::string(200'000, 'p')
+    }.Dump();
+    std::string output(expected.size() + 1, '\0');
+    ASSERT_EQ(lseek(fd, 0, SEEK_SET), 0);
+    output.resize(read(fd, output.data(), output.size()));
+    std::fclose(file);
+    EXPECT_EQ(output, expected);
+}
+
+//
+// Errors
+//
+
+TEST(BencodeWriterTest, keyOrder) {
+    check_write_error(WriteID::kDictBadOrder, [](BencodeWriter& writer) {
+        writer.begin_dict();
+        writer.key("foo");
+        writer.value(1l);
+        writer.key("bar");
+    });
+    check_write_error(WriteID::kDictDuplicateKeys, [](BencodeWriter& writer) {
+        writer.begin_dict();
+        writer.key("foo");
+        writer.value(1l);
+        writer.key("foo");
+    });
+}
+
+TEST(BencodeWriterTest, dictPairs) {
+    check_write_error(WriteID::kValueWithoutKey, [](BencodeWriter& writer) {
+        writer.begin_dict();
+        writer.value(1l);
+    });
+    check_write_error(WriteID::kDictIncompletePair, [](BencodeWriter& writer) {
+        writer.begin_dict();
+        writer.key("foo");
+        writer.end_dict();
+    });
+    check_write_error(WriteID::kDictIncompletePair, [](BencodeWriter& writer) {
+        writer.begin_dict();
+        writer.key("foo");
+        writer.key("zoo");
+    });
+    check_write_error(WriteID::kKeyOutsideDict, [](BencodeWriter& writer) {
+        writer.begin_list();
+        writer.key("foo");
+    });
+}
+
+TEST(BencodeWriterTest, structure) {
+    check_write_error(WriteID::kMismatchedEnd, [](BencodeWriter& writer) {
+        writer.begin_list();
+        writer.end_dict();
+    });
+    check_write_error(WriteID::kMismatchedEnd, [](BencodeWriter& writer) {
+        writer.end_list();
+    });
+    check_write_error(WriteID::kTooMuchData, [](BencodeWriter& writer) {
+        writer.value(1l);
+        writer.value(2l);
+    });
+    check_write_error(WriteID::kIncomplete, [](BencodeWriter& writer) {
+        writer.begin_list();
+        writer.finish();
+    });
+    check_write_error(WriteID::kIncomplete, [](BencodeWriter& writer) {
+        writer.finish();
+    });
+}
+
+TEST(BencodeWriterTest, stringParts) {
+    check_write_error(WriteID::kStringLength, [](BencodeWriter& writer) {
+        writer.begin_string(2);
+        writer.append_string("foo");
+    });
+    check_write_error(WriteID::kStringLength, [](BencodeWriter& writer) {
+        writer.begin_list();
+        writer.begin_string(2);
+        writer.append_string("f");
+        writer.end_list();
+    });
+}
+
+TEST(BencodeWriterTest, writeNullNode) {
+    std::string output;
+    BencodeWriter writer(output);
+    EXPECT_THROW({writer.value(Bencode {});}, Bencode::DumpError);
+    writer.value(1l);
+    writer.finish();
+    EXPECT_EQ(output, "i1e");
+}
+
+TEST(BencodeWriterTest, writeNestedNullNode) {
+    std::string output;
+    BencodeWriter writer(output);
+    writer.begin_list();
+    Bencode node = Bencode::List {1l, Bencode::List {}};
+    node[1].push_back(Bencode {});
+    EXPECT_THROW({writer.value(node);}, Bencode::DumpError);
+    EXPECT_EQ(output, "l");
+    writer.value(2l);
+    writer.end_list();
+    writer.finish();
+    EXPECT_EQ(output, "li2ee");
+}
@@ -0,0 +1,92 @@
+#include <gtest/gtest.h>
+#include "../src/mapped_file.h"
+
+#include <fstream>
+#include <string>
+#include <system_error>
+
+#include <sys/stat.h>
+
+std::filesystem::path write_mapped_test_file(std::string_view name,
+                                             std::string_view content) {
+    std::filesystem::path path =
+        std::filesystem::temp_directory_path() / name;
+    std::ofstream file(path, std::ios::binary);
+    file.write(content.data(), content.size());
+    return path;
+}
+
+TEST(MappedFileTest, mapContent) {
+    std::filesystem::path path =
+        write_mapped_test_file("ftor_mapped_content", "d3:foo3:bare");
+    MappedFile dut(path);
+    EXPECT_EQ(dut.size(), 12);
+    EXPECT_EQ(dut.data(), "d3:foo3:bare");
+    EXPECT_EQ(dut.bytes().size(), 12);
+    EXPECT_EQ(dut.bytes()[0], std::byte('d'));
+    std::filesystem::remove(path);
+}
+
+TEST(MappedFileTest, mapLargeFile) {
+    std::string content(MappedFile::kMapThreshold + 1, 'a');
+    content.front() = 'b';
+    content.back() = 'c';
+    std::filesystem::path path =
+        write_mapped_test_file("ftor_mapped_large", content);
+    MappedFile dut(path);
+    EXPECT_EQ(dut.size(), content.size());
+    EXPECT_EQ(dut.data(), content);
+    std::filesystem::remove(path);
+}
+
+TEST(MappedFileTest, mapEmptyFile) {
+    std::filesystem::path path =
+        write_mapped_test_file("ftor_mapped_empty", "");
+    MappedFile dut(path);
+    EXPECT_EQ(dut.size(), 0);
+    EXPECT_TRUE(dut.data().empty());
+    std::filesystem::remove(path);
+}
+
+TEST(MappedFileTest, mapMissingFile) {
+    EXPECT_THROW({MappedFile dut("/nonexistent/ftor_mapped_missing");},
+                 std::system_error);
+}
+
+TEST(MappedFileTest, mapDirectory) {
+    try {
+        MappedFile dut(std::filesystem::temp_directory_path());
+        FAIL() << "Expected std::system_error";
+    }
+    catch (const std::system_error& e) {
+        EXPECT_EQ(e.code(), std::errc::is_a_directory);
+    }
+}
+
+TEST(MappedFileTest, mapFifo) {
+    std::filesystem::path path =
+        std::filesystem::temp_directory_path() / "ftor_mapped_fifo";
+    std::filesystem::remove(path);
+    ASSERT_EQ(mkfifo(path.c_str(), 0600), 0);
+    EXPECT_THROW({MappedFile dut(path);}, std::system_error);
+    std::filesystem::remove(path);
+}
+
+TEST(MappedFileTest, mapSyntheticFile) {
+    std::filesystem::path path = "/proc/self/status";
+    if (!std::filesystem::exists(path))
+        GTEST_SKIP() << "no /proc";
+    EXPECT_THROW({MappedFile dut(path);}, std::system_error);
+}
+
+TEST(MappedFileTest, moveKeepsMapping) {
+    std::filesystem::path path =
+        write_mapped_test_file("ftor_mapped_move", "i42e");
+    MappedFile source(path);
+    const char *address = source.data().data();
+    MappedFile dut(std::move(source));
+    EXPECT_TRUE(source.data().empty());
+    EXPECT_EQ(dut.data().data(), address);
+    EXPECT_EQ(dut.data(), "i42e");
+    std::filesystem::remove(path);
+}
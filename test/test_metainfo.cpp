@@ -2,6 +2,7 @@
 #include "../src/metainfo.h"
 
 #include <cmath>
+#include <fstream>
 #include <numeric>
 
 #include <openssl/sha.h>
@@ -449,6 +450,60 @@ TEST(MetainfoTest, piecesLengthMismatch) {
         Metainfo::MetainfoError::ExceptionID::kPiecesLengthMismatch);
 }
 
+TEST(MetainfoTest, severalErrorsInvalidSchemeBeforeMissingName) {
+    Bencode input_elem = nominal_input();
+    input_elem["announce"] = "udp://test_announce.org";
+    input_elem["info"].erase("name");
+    std::istringstream input(input_elem.Dump());
+    check_metainfo_exception(input,
+        Metainfo::MetainfoError::ExceptionID::kAnnounceInvalidScheme);
+}
+
+TEST(MetainfoTest, severalErrorsInvalidURLBeforeMissingInfo) {
+    Bencode input_elem = nominal_input();
+    input_elem["announce"] = "http://test announce.org";
+    input_elem.erase("info");
+    std::istringstream input(input_elem.Dump());
+    check_metainfo_exception(input,
+        Metainfo::MetainfoError::ExceptionID::kAnnounceInvalidURL);
+}
+
+TEST(MetainfoTest, severalErrorsBothLengthAndFilesBeforeFilesType) {
+    Bencode input_elem = nominal_input();
+    input_elem["info"]["length"] = 1l;
+    input_elem["info"]["files"] = 0l;
+    std::istringstream input(input_elem.Dump());
+    check_metainfo_exception(input,
+        Metainfo::MetainfoError::ExceptionID::kBothLengthAndFiles);
+}
+
+TEST(MetainfoTest, severalErrorsFilesEmptyBeforeMissingPieces) {
+    Bencode input_elem = nominal_input();
+    input_elem["info"]["files"].clear();
+    input_elem["info"].erase("pieces");
+    std::istringstream input(input_elem.Dump());
+    check_metainfo_exception(input,
+        Metainfo::MetainfoError::ExceptionID::kFilesEmpty);
+}
+
+TEST(MetainfoTest, severalErrorsFirstFileBeforeSecond) {
+    Bencode input_elem = nominal_input();
+    input_elem["info"]["files"][0]["length"] = "";
+    input_elem["info"]["files"][1] = "";
+    std::istringstream input(input_elem.Dump());
+    check_metainfo_exception(input,
+        Metainfo::MetainfoError::ExceptionID::kFileLengthNotInt);
+}
+
+TEST(MetainfoTest, severalErrorsNameTypeBeforePieceLength) {
+    Bencode input_elem = nominal_input();
+    input_elem["info"]["name"] = 0l;
+    input_elem["info"].erase("piece length");
+    std::istringstream input(input_elem.Dump());
+    check_metainfo_exception(input,
+        Metainfo::MetainfoError::ExceptionID::kNameNotString);
+}
+
 TEST(MetainfoTest, checkNumbeofPieces) {
     Bencode input_elem = nominal_input();
     std::istringstream input(input_elem.Dump());
@@ -595,3 +650,184 @@ TEST(MetainfoTest, getInfoHash) {
     for (std::size_t i = 0; i < 20; i++)
         EXPECT_EQ(std::to_integer<unsigned char>(output[i]), expected_hash[i]);
 }
+
+TEST(MetainfoTest, fromBencode) {
+    Metainfo dut(nominal_input());
+    EXPECT_EQ(dut.get_name(), "test_name");
+    EXPECT_EQ(dut.get_file_list().size(), 2);
+}
+
+TEST(MetainfoTest, fromFile) {
+    Bencode input_elem = nominal_input();
+    std::filesystem::path path =
+        std::filesystem::temp_directory_path() / "ftor_metainfo_from_file";
+    std::ofstream(path, std::ios::binary) << input_elem;
+
+    std::istringstream input(input_elem.Dump());
+    Metainfo expected(input);
+    Metainfo dut = Metainfo::FromFile(path);
+    std::filesystem::remove(path);
+
+    EXPECT_EQ(dut.get_name(), expected.get_name());
+    EXPECT_EQ(dut.get_total_length(), expected.get_total_length());
+    EXPECT_EQ(dut.get_piece_list().size(), expected.get_piece_list().size());
+    EXPECT_EQ(dut.get_info_hash(), expected.get_info_hash());
+}
+
+TEST(MetainfoTest, fromBuffer) {
+    std::string input = nominal_input().Dump();
+    Metainfo dut = Metainfo::FromBuffer(input);
+    EXPECT_EQ(dut.get_name(), "test_name");
+    EXPECT_EQ(dut.get_info_hash(), Metainfo(nominal_input()).get_info_hash());
+}
+
+TEST(MetainfoTest, infoHashOverOriginalBytes) {
+    Bencode input_elem = nominal_input();
+    std::string input = input_elem.Dump();
+    std::string info_dump = input_elem.at("info").Dump();
+    std::size_t info_begin = input.find(info_dump);
+    ASSERT_NE(info_begin, std::string::npos);
+
+    // Hashing the source must not read past the info dictionary
+    std::string_view info_bytes(input.data() + info_begin, info_dump.size());
+    std::vector<std::byte> expected_hash(20);
+    SHA1(reinterpret_cast<const unsigned char*>(info_bytes.data()),
+        info_bytes.size(),
+        reinterpret_cast<unsigned char*>(expected_hash.data()));
+
+    Metainfo dut = Metainfo::FromBuffer(input);
+    EXPECT_EQ(dut.get_info_hash(), expected_hash);
+}
+
+TEST(MetainfoTest, tryCreateMatchesFromBuffer) {
+    std::string input = nominal_input().Dump();
+    auto dut = Metainfo::TryCreate(input);
+    ASSERT_TRUE(dut.has_value());
+    Metainfo expected = Metainfo::FromBuffer(input);
+    EXPECT_EQ(dut->get_name(), expected.get_name());
+    EXPECT_EQ(dut->get_total_length(), expected.get_total_length());
+    EXPECT_EQ(dut->get_piece_list().size(), expected.get_piece_list().size());
+    EXPECT_EQ(dut->get_info_hash(), expected.get_info_hash());
+}
+
+TEST(MetainfoTest, tryCreateEncodingError) {
+    auto dut = Metainfo::TryCreate("d8:announcei1e");
+    ASSERT_FALSE(dut.has_value());
+    ASSERT_TRUE(std::holds_alternative<Bencode::ParseFailure>(dut.error()));
+    EXPECT_EQ(std::get<Bencode::ParseFailure>(dut.error()).id,
+              Bencode::ParseError::ExceptionID::kUnexpectedEOF);
+}
+
+TEST(MetainfoTest, tryCreateErrorsMatchConstructor) {
+    Bencode mismatch = nominal_input();
+    mismatch["info"]["pieces"] = std::string(20, 'a');
+    Bencode no_path = nominal_input();
+    no_path["info"]["files"][1]["path"] = Bencode::List {};
+    Bencode bad_url = nominal_input();
+    bad_url["announce"] = "http://bad url";
+    std::vector<std::string> input_list {
+        "", "le", "de", "d8:announcei1ee", mismatch.Dump(), no_path.Dump(),
+        bad_url.Dump()
+    };
+    for (const std::string& input : input_list) {
+        SCOPED_TRACE(input.substr(0, 64));
+        auto dut = Metainfo::TryCreate(input);
+        ASSERT_FALSE(dut.has_value());
+        ASSERT_TRUE(std::holds_alternative<
+            Metainfo::MetainfoError::ExceptionID>(dut.error()));
+        std::istringstream stream(input);
+        check_metainfo_exception(stream,
+            std::get<Metainfo::MetainfoError::ExceptionID>(dut.error()));
+    }
+}
+
+TEST(MetainfoTest, tryFromFileMissing) {
+    auto dut = Metainfo::TryFromFile(
+        std::filesystem::temp_directory_path() / "ftor_metainfo_missing");
+    ASSERT_FALSE(dut.has_value());
+    ASSERT_TRUE(std::holds_alternative<std::error_code>(dut.error()));
+    EXPECT_EQ(std::get<std::error_code>(dut.error()),
+              std::errc::no_such_file_or_directory);
+}
+
+TEST(MetainfoTest, loadBatchBuffersInOrder) {
+    std::string nominal = nominal_input().Dump();
+    std::vector<std::string_view> buffers {};
+    for (std::size_t i = 0; i < 64; i++)
+        buffers.push_back(i % 3 == 1 ? std::string_view("le") : nominal);
+
+    std::vector<Metainfo::Result> results = Metainfo::LoadBatch(buffers, 4);
+    ASSERT_EQ(results.size(), buffers.size());
+    for (std::size_t i = 0; i < results.size(); i++) {
+        SCOPED_TRACE(i);
+        if (i % 3 == 1) {
+            ASSERT_FALSE(results[i].has_value());
+            EXPECT_EQ(std::get<Metainfo::MetainfoError::ExceptionID>(
+                          results[i].error()),
+                      Metainfo::MetainfoError::ExceptionID::kTopLevelNotDict);
+        }
+        else {
+            ASSERT_TRUE(results[i].has_value());
+            EXPECT_EQ(results[i]->get_name(), "test_name");
+        }
+    }
+}
+
+TEST(MetainfoTest, loadBatchFiles) {
+    std::filesystem::path directory = std::filesystem::temp_directory_path();
+    std::vector<std::filesystem::path> paths {
+        directory / "ftor_metainfo_batch_0",
+        directory / "ftor_metainfo_batch_missing",
+        directory / "ftor_metainfo_batch_2"
+    };
+    std::ofstream(paths[0], std::ios::binary) << nominal_input();
+    std::ofstream(paths[2], std::ios::binary) << "i1e";
+
+    std::vector<Metainfo::Result> results = Metainfo::LoadBatch(paths, 2);
+    std::filesystem::remove(paths[0]);
+    std::filesystem::remove(paths[2]);
+
+    ASSERT_EQ(results.size(), 3);
+    ASSERT_TRUE(results[0].has_value());
+    EXPECT_EQ(results[0]->get_info_hash(),
+              Metainfo(nominal_input()).get_info_hash());
+    ASSERT_FALSE(results[1].has_value());
+    EXPECT_TRUE(std::holds_alternative<std::error_code>(results[1].error()));
+    ASSERT_FALSE(results[2].has_value());
+    EXPECT_TRUE(std::holds_alternative<Metainfo::MetainfoError::ExceptionID>(
+        results[2].error()));
+}
+
+TEST(MetainfoTest, loadBatchCallback) {
+    std::string nominal = nominal_input().Dump();
+    std::vector<std::string_view> buffers(32, nominal);
+    buffers[5] = "d3:foo";
+
+    std::vector<int> calls(buffers.size(), 0);
+    std::size_t loaded = 0;
+    Metainfo::LoadBatch(buffers,
+        [&](std::size_t index, Metainfo::Result result) {
+            calls[index]++;
+            if (result)
+                loaded++;
+        }, 4);
+    EXPECT_EQ(calls, std::vector<int>(buffers.size(), 1));
+    EXPECT_EQ(loaded, buffers.size() - 1);
+}
+
+TEST(MetainfoTest, loadBatchCallbackException) {
+    std::string nominal = nominal_input().Dump();
+    std::vector<std::string_view> buffers(16, nominal);
+    EXPECT_THROW({
+        Metainfo::LoadBatch(buffers,
+            [](std::size_t index, Metainfo::Result) {
+                if (index == 3)
+                    throw std::runtime_error("stop");
+            }, 4);
+    }, std::runtime_error);
+}
+
+TEST(MetainfoTest, loadBatchEmpty) {
+    EXPECT_TRUE(Metainfo::LoadBatch(
+        std::span<const std::string_view> {}).empty());
+}